@@ -0,0 +1,115 @@
+#include "bench.h"
+#include <algorithm>
+#include <cmath>
+#include <fmt/format.h>
+#include <thread>
+#include <util/field_kernel.h>
+
+namespace phy::bench
+{
+    runner::runner(std::string filter, double min_time, std::size_t repetitions)
+        : filter(std::move(filter)), min_time(min_time), repetitions(std::max<std::size_t>(repetitions, 1))
+    {
+    }
+
+    void runner::run(const std::string& name, double items, const std::function<void()>& fn)
+    {
+        if (!enabled(name))
+            return;
+
+        auto time = [&](std::size_t n) {
+            auto begin = clock::now();
+            for (std::size_t i = 0; i < n; i++)
+                fn();
+            return std::chrono::duration<double>(clock::now() - begin).count();
+        };
+
+        // warm up, then grow the iteration count until one repetition takes min_time; that run is the first sample
+        time(1);
+        std::size_t n = 1;
+        double elapsed = time(n);
+        while (elapsed < min_time)
+        {
+            double scale = elapsed > 0 ? 1.2 * min_time / elapsed : 10;
+            n = std::max<std::size_t>(n + 1, n * std::min(scale, 10.0));
+            elapsed = time(n);
+        }
+
+        std::vector<double> samples{elapsed / n * 1e9};
+        for (std::size_t i = 1; i < repetitions; i++)
+            samples.push_back(time(n) / n * 1e9);
+        std::sort(samples.begin(), samples.end());
+
+        result r;
+        r.name = name;
+        r.iterations = n;
+        r.repetitions = samples.size();
+        r.ns_median = samples[samples.size() / 2];
+        r.ns_min = samples.front();
+        r.items = items;
+        record(std::move(r));
+    }
+
+    void runner::record(result r)
+    {
+        fmt::print(stderr, "{:<56} {:>14.1f} ns", r.name, r.ns_median);
+        if (r.items > 0 && r.ns_median > 0)
+            fmt::print(stderr, " {:>12.4g} items/s", r.items / r.ns_median * 1e9);
+        for (const auto& [k, v] : r.counters)
+            fmt::print(stderr, " {}={:.4g}", k, v);
+        fmt::print(stderr, "\n");
+
+        results.push_back(std::move(r));
+    }
+
+    static std::string quote(const std::string& s)
+    {
+        std::string ret = "\"";
+        for (char c : s)
+        {
+            if (c == '"' || c == '\\')
+                ret += '\\';
+            ret += c;
+        }
+        return ret + '"';
+    }
+
+    // JSON has no representation for infinities and NaN
+    static std::string number(double d) { return std::isfinite(d) ? fmt::format("{}", d) : "null"; }
+
+    std::string runner::to_json() const
+    {
+#ifdef NDEBUG
+        constexpr bool debug = false;
+#else
+        constexpr bool debug = true;
+#endif
+#ifdef __VERSION__
+        const char* compiler = __VERSION__;
+#else
+        const char* compiler = "unknown";
+#endif
+
+        std::string ret = fmt::format(
+            "{{\n  \"context\": {{\"compiler\": {}, \"debug\": {}, \"isa\": {}, \"hardware_threads\": {}, "
+            "\"min_time\": {}, \"repetitions\": {}}},\n  \"benchmarks\": [",
+            quote(compiler), debug, quote(kernel::name(kernel::active())), std::thread::hardware_concurrency(),
+            min_time, repetitions);
+
+        for (std::size_t i = 0; i < results.size(); i++)
+        {
+            const result& r = results[i];
+            ret += fmt::format("{}\n    {{\"name\": {}, \"iterations\": {}, \"repetitions\": {}, \"ns_median\": {}, "
+                               "\"ns_min\": {}",
+                               i ? "," : "", quote(r.name), r.iterations, r.repetitions, number(r.ns_median),
+                               number(r.ns_min));
+            if (r.items > 0 && r.ns_median > 0)
+                ret += fmt::format(", \"items_per_second\": {}", number(r.items / r.ns_median * 1e9));
+            for (const auto& [k, v] : r.counters)
+                ret += fmt::format(", {}: {}", quote(k), number(v));
+            ret += "}";
+        }
+
+        return ret + "\n  ]\n}\n";
+    }
+} // namespace phy::bench
@@ -0,0 +1,74 @@
+#ifndef __PHY_BENCH_H__
+#define __PHY_BENCH_H__
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace phy::bench
+{
+    // keeps the compiler from dropping a computation whose result is otherwise unused
+    template <typename T>
+    inline void keep(const T& value)
+    {
+#if defined(__GNUC__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static volatile const void* sink;
+        sink = &value;
+#endif
+    }
+
+    struct result
+    {
+        std::string name;
+        std::size_t iterations = 0;
+        std::size_t repetitions = 0;
+        double ns_median = 0;
+        double ns_min = 0;
+        // work items per iteration (pairs, bodies, ...), 0 if the benchmark has no natural unit
+        double items = 0;
+        std::vector<std::pair<std::string, double>> counters;
+    };
+
+    class runner
+    {
+        using clock = std::chrono::steady_clock;
+
+        std::string filter;
+        double min_time;
+        std::size_t repetitions;
+        std::vector<result> results;
+
+    public:
+        // every benchmark is repeated `repetitions` times, each repetition running for at least `min_time` seconds
+        runner(std::string filter, double min_time, std::size_t repetitions);
+
+        inline bool enabled(const std::string& name) const
+        {
+            return filter.empty() || name.find(filter) != std::string::npos;
+        }
+
+        // Times `fn`, which runs one iteration of benchmark `name` over `items` work items, unless the name is
+        // filtered out. Setup that should not be timed belongs outside of `fn`.
+        void run(const std::string& name, double items, const std::function<void()>& fn);
+
+        // records a result measured by the caller, for benchmarks that are not a timed loop
+        void record(result r);
+
+        constexpr const std::vector<result>& get_results() const { return results; }
+        std::string to_json() const;
+    };
+
+    // every generator is seeded the same, so that runs are comparable
+    inline std::mt19937_64 make_rng(std::uint64_t stream = 0) { return std::mt19937_64(0x5eed + stream); }
+
+    void run_micro(runner& r);
+    void run_scenes(runner& r, std::size_t max_bodies, std::size_t threads);
+} // namespace phy::bench
+
+#endif
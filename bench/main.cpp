@@ -0,0 +1,84 @@
+#include "bench.h"
+#include <fmt/format.h>
+#include <fstream>
+#include <iostream>
+#include <string_view>
+
+using namespace phy::bench;
+
+struct bench_options
+{
+    std::string filter;
+    const char* out = nullptr;
+    double min_time = 0.2;
+    std::size_t repetitions = 5;
+    std::size_t max_bodies = 1000000;
+    std::size_t threads = 1;
+    bool micro = true;
+    bool scenes = true;
+};
+
+bool parse_args(int argc, char** argv, bench_options& opts)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string_view arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc)
+            opts.filter = argv[++i];
+        else if (arg == "--out" && i + 1 < argc)
+            opts.out = argv[++i];
+        else if (arg == "--min-time" && i + 1 < argc)
+            opts.min_time = std::strtod(argv[++i], nullptr);
+        else if (arg == "--repetitions" && i + 1 < argc)
+            opts.repetitions = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--max-bodies" && i + 1 < argc)
+            opts.max_bodies = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--threads" && i + 1 < argc)
+            opts.threads = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--micro")
+            opts.scenes = false;
+        else if (arg == "--scenes")
+            opts.micro = false;
+        else
+            return false;
+    }
+
+    return true;
+}
+
+// Runs the benchmarks and writes their results as JSON to stdout or --out, progress goes to stderr. Every scene is
+// generated from a fixed seed, so results from different builds can be compared name by name.
+int main(int argc, char** argv)
+{
+    bench_options opts;
+    if (!parse_args(argc, argv, opts))
+    {
+        std::cerr << fmt::format("usage: {} [--filter substring] [--out file] [--min-time s] [--repetitions n] "
+                                 "[--max-bodies n] [--threads n] [--micro | --scenes]\n",
+                                 argv[0]);
+        return -1;
+    }
+
+    runner r(opts.filter, opts.min_time, opts.repetitions);
+    if (opts.micro)
+        run_micro(r);
+    if (opts.scenes)
+        run_scenes(r, opts.max_bodies, opts.threads);
+
+    std::string json = r.to_json();
+    if (!opts.out)
+    {
+        std::cout << json;
+        return 0;
+    }
+
+    std::ofstream os(opts.out);
+    os << json;
+    if (!os)
+    {
+        std::cerr << fmt::format("failed to write {}\n", opts.out);
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,262 @@
+#include "bench.h"
+#include <algorithm>
+#include <cmath>
+#include <component/force.h>
+#include <component/movement.h>
+#include <fmt/format.h>
+#include <numbers>
+#include <physics.h>
+#include <special_object.h>
+#include <tracker.h>
+#include <util/aligned.h>
+#include <util/field_kernel.h>
+
+namespace phy::bench
+{
+    static constexpr std::size_t N = 4096;
+
+    static std::vector<vec2d> random_vecs(std::size_t n, double min_len, double max_len, std::uint64_t stream)
+    {
+        auto rng = make_rng(stream);
+        std::uniform_real_distribution<double> len(min_len, max_len);
+        std::uniform_real_distribution<double> angle(0, 2 * std::numbers::pi);
+
+        std::vector<vec2d> ret(n);
+        for (auto& i : ret)
+        {
+            double r = len(rng);
+            double a = angle(rng);
+            i = vec2d{r * std::cos(a), r * std::sin(a)};
+        }
+        return ret;
+    }
+
+    static void bench_vec(runner& r)
+    {
+        auto a = random_vecs(N, 0.5, 100, 1);
+        auto b = random_vecs(N, 0.5, 100, 2);
+        std::vector<vec2d> out(N);
+
+        r.run("vec/add", N, [&] {
+            for (std::size_t i = 0; i < N; i++)
+                out[i] = a[i] + b[i];
+            keep(out.data());
+        });
+
+        r.run("vec/dot", N, [&] {
+            double sum = 0;
+            for (std::size_t i = 0; i < N; i++)
+                sum += a[i].dot(b[i]);
+            keep(sum);
+        });
+
+        r.run("vec/magnitude", N, [&] {
+            double sum = 0;
+            for (std::size_t i = 0; i < N; i++)
+                sum += a[i].magnitude();
+            keep(sum);
+        });
+
+        r.run("vec/normalize", N, [&] {
+            for (std::size_t i = 0; i < N; i++)
+                out[i] = a[i].normalize();
+            keep(out.data());
+        });
+
+        std::vector<double> xd(N);
+        std::vector<float> xf(N);
+        for (std::size_t i = 0; i < N; i++)
+            xf[i] = xd[i] = a[i].dot(a[i]);
+
+        r.run("invsqrt/float", N, [&] {
+            float sum = 0;
+            for (auto i : xf)
+                sum += invsqrt(i);
+            keep(sum);
+        });
+
+        r.run("invsqrt/double", N, [&] {
+            double sum = 0;
+            for (auto i : xd)
+                sum += invsqrt(i);
+            keep(sum);
+        });
+
+        // what invsqrt competes against
+        r.run("invsqrt/std_sqrt", N, [&] {
+            double sum = 0;
+            for (auto i : xd)
+                sum += 1 / std::sqrt(i);
+            keep(sum);
+        });
+    }
+
+    template <typename F>
+    static void bench_field_force(runner& r, const std::string& name, const F& f)
+    {
+        // displacements stay clear of the distance gravity clamps and warns at
+        auto disp = random_vecs(N, 1, 100, 3);
+        auto mass = random_vecs(N, 1, 10, 4);
+        const forces::field_force& virt = f;
+
+        r.run(fmt::format("forces/{}/eval", name), N, [&] {
+            vec2d sum;
+            for (std::size_t i = 0; i < N; i++)
+                sum += f.eval(disp[i], mass[i][0], mass[i][1]);
+            keep(sum);
+        });
+
+        r.run(fmt::format("forces/{}/virtual", name), N, [&] {
+            vec2d sum;
+            for (std::size_t i = 0; i < N; i++)
+                sum += virt.field(disp[i], mass[i][0], mass[i][1]);
+            keep(sum);
+        });
+    }
+
+    template <typename F>
+    static void bench_body_force(runner& r, const std::string& name, const F& f)
+    {
+        auto vel = random_vecs(N, 0.5, 100, 5);
+        auto mass = random_vecs(N, 1, 10, 6);
+
+        r.run(fmt::format("forces/{}/eval", name), N, [&] {
+            vec2d sum;
+            for (std::size_t i = 0; i < N; i++)
+                sum += f.eval(mass[i][0], vel[i]);
+            keep(sum);
+        });
+    }
+
+    static void bench_kernel(runner& r)
+    {
+        constexpr std::size_t SOURCES = 4096;
+        constexpr std::size_t TARGETS = 1024;
+
+        auto src = random_vecs(SOURCES, 0, 1000, 7);
+        auto tgt = random_vecs(TARGETS, 0, 1000, 8);
+
+        aligned_vector<double> sx(SOURCES), sy(SOURCES), sm(SOURCES, 1.0), tx(TARGETS), ty(TARGETS);
+        aligned_vector<double> ax(TARGETS), ay(TARGETS);
+        for (std::size_t i = 0; i < SOURCES; i++)
+        {
+            sx[i] = src[i][0];
+            sy[i] = src[i][1];
+        }
+        for (std::size_t i = 0; i < TARGETS; i++)
+        {
+            tx[i] = tgt[i][0];
+            ty[i] = tgt[i][1];
+        }
+
+        const kernel::law gravity[] = {{1, 2, 10}};
+        const kernel::law mixed[] = {{1, 2, 10}, {-0.5, 3, 10}};
+        const kernel::law softened[] = {{1, 2, 0, 0.01}};
+
+        kernel::isa prev = kernel::active();
+        for (auto isa : {kernel::isa::SCALAR, kernel::isa::AVX2, kernel::isa::AVX512})
+        {
+            if (isa > kernel::detect())
+                break;
+            kernel::select(isa);
+
+            for (auto [name, laws, n] : {std::tuple{"gravity", gravity, 1}, std::tuple{"two_laws", mixed, 2},
+                                         std::tuple{"softened_gravity", softened, 1}})
+            {
+                r.run(fmt::format("kernel/field_sum/{}/{}", name, kernel::name(isa)), SOURCES * TARGETS, [&] {
+                    kernel::field_sum(laws, n, sx.data(), sy.data(), sm.data(), SOURCES, tx.data(), ty.data(), 0,
+                                      TARGETS, ax.data(), ay.data());
+                    keep(ax.data());
+                });
+            }
+        }
+        kernel::select(prev);
+    }
+
+    template <typename C>
+    static void bench_controller(runner& r, const std::string& name)
+    {
+        physics_space space(1, 1);
+        space.create_class<C>("body").build();
+
+        auto pos = random_vecs(N, 0, 1000, 9);
+        auto vel = random_vecs(N, 0, 10, 10);
+        auto force = random_vecs(N, 0, 10, 11);
+
+        std::vector<object*> objs;
+        for (std::size_t i = 0; i < N; i++)
+            objs.push_back(&space.create_object("body", 1, {}).pos(pos[i]).vel(vel[i]).get());
+
+        std::size_t stages = C().stages();
+        r.run(fmt::format("controller/{}", name), N, [&] {
+            for (std::size_t stage = 0; stage < stages; stage++)
+            {
+                for (std::size_t i = 0; i < N; i++)
+                    objs[i]->update(1e-3, force[i], stage);
+            }
+        });
+    }
+
+    // a chain of N springs, as one network
+    static void bench_spring_network(runner& r)
+    {
+        physics_space space(1, 1);
+        space.create_class<movement::default_controller>("node").build();
+
+        auto pos = random_vecs(N + 1, 0, 1000, 12);
+        std::vector<object*> objs;
+        for (std::size_t i = 0; i <= N; i++)
+            objs.push_back(&space.create_object("node", 1, {}).pos(pos[i]).get());
+
+        spring_network springs;
+        for (std::size_t i = 0; i < N; i++)
+            springs.add(*objs[i], *objs[i + 1], sf::Color::White, 10, 1);
+
+        std::vector<vec2d> forces(N + 1);
+        r.run("special/spring_network/handle_forces", N, [&] {
+            springs.handle_forces(space, forces, 1e-3);
+            keep(forces.data());
+        });
+    }
+
+    static void bench_tracker(runner& r)
+    {
+        physics_space space(1, 1);
+        space.create_class<movement::default_controller>("body").build();
+
+        auto pos = random_vecs(N, 0, 1000, 13);
+        auto vel = random_vecs(N, 0, 10, 14);
+
+        // samples on every update, cycling through every statistic
+        tracker t(0.5e-3, 64, 3);
+        for (std::size_t i = 0; i < N; i++)
+        {
+            object& obj = space.create_object("body", 1, {}).pos(pos[i]).vel(vel[i]).get();
+            t.track(obj, (statspec_types)(i % ((std::size_t)statspec_types::KE + 1)), sf::Color::White);
+        }
+
+        r.run("tracker/handle_update", N, [&] { t.handle_update(space, 1e-3); });
+    }
+
+    void run_micro(runner& r)
+    {
+        bench_vec(r);
+
+        bench_field_force(r, "gravity", forces::gravity(1));
+        bench_field_force(r, "softened_gravity", forces::softened_gravity(1, 0.1));
+        bench_field_force(r, "simple_field/2", forces::simple_field(1, 2));
+        bench_field_force(r, "simple_field/1.5", forces::simple_field(1, 1.5));
+        bench_body_force(r, "force_drag", forces::force_drag(0.1, 2));
+        bench_body_force(r, "const_acc", forces::const_acc(vec2d{0, -9.8}));
+        bench_kernel(r);
+
+        bench_controller<movement::default_controller>(r, "default");
+        bench_controller<movement::fixed_controller>(r, "fixed");
+        bench_controller<movement::verlet_controller>(r, "verlet");
+        bench_controller<movement::yoshida4_controller>(r, "yoshida4");
+        bench_controller<movement::rk4_controller>(r, "rk4");
+
+        bench_spring_network(r);
+        bench_tracker(r);
+    }
+} // namespace phy::bench
@@ -0,0 +1,548 @@
+#include "bench.h"
+#include <algorithm>
+#include <cmath>
+#include <component/movement.h>
+#include <fmt/format.h>
+#include <numbers>
+#include <physics.h>
+#include <thread>
+
+namespace phy::bench
+{
+    static constexpr std::size_t SCENE_SIZES[] = {10, 100, 1000, 10000, 100000, 1000000};
+    // the direct sum is quadratic, past this it would dominate the whole run
+    static constexpr std::size_t MAX_DIRECT = 10000;
+    static constexpr double DT = 1e-3;
+
+    // n bodies of unit mass at rest, spread uniformly over a disk wide enough that close encounters stay rare
+    template <typename C = movement::verlet_controller>
+    static std::unique_ptr<physics_space> make_cloud(std::size_t n, double theta, std::size_t threads,
+                                                     bool gravity = true)
+    {
+        auto space = std::make_unique<physics_space>(1, 1);
+        space->set_threads(threads);
+        space->set_opening_angle(theta);
+
+        auto& c = space->create_class<C>("body");
+        if (gravity)
+            c.gravity(1e-3);
+        c.build();
+
+        auto rng = make_rng(n);
+        std::uniform_real_distribution<double> unit(0, 1);
+        double radius = 1000 * std::sqrt((double)n);
+        for (std::size_t i = 0; i < n; i++)
+        {
+            double r = radius * std::sqrt(unit(rng));
+            double a = 2 * std::numbers::pi * unit(rng);
+            space->create_object("body", 1, {}).pos(r * std::cos(a), r * std::sin(a));
+        }
+
+        return space;
+    }
+
+    // n particles with a short range repulsion at liquid-like density, evaluated through the cell grid or, with a
+    // skin, through neighbor lists
+    static std::unique_ptr<physics_space> make_particles(std::size_t n, std::size_t threads, double skin)
+    {
+        auto space = std::make_unique<physics_space>(1, 1);
+        space->set_threads(threads);
+        space->set_neighbor_skin(skin);
+        space->create_class<movement::verlet_controller>("particle").field(-50, 6, 2.5).build();
+
+        // a jittered lattice, so that no two particles start close enough to blow the scene apart
+        auto rng = make_rng(n);
+        std::size_t row = (std::size_t)std::ceil(std::sqrt((double)n));
+        std::uniform_real_distribution<double> jitter(-0.2, 0.2);
+        for (std::size_t i = 0; i < n; i++)
+            space->create_object("particle", 1, {}).pos(1.2 * (i % row) + jitter(rng), 1.2 * (i / row) + jitter(rng));
+
+        return space;
+    }
+
+    // n fixed attractors, which only act as sources, and n / 100 probes moving through them, summed directly
+    static std::unique_ptr<physics_space> make_star_field(std::size_t n, std::size_t threads)
+    {
+        auto space = std::make_unique<physics_space>(1, 1);
+        space->set_threads(threads);
+        space->create_class<movement::fixed_controller>("star").gravity(1e-3).build();
+        space->create_class<movement::verlet_controller>("probe").build();
+
+        auto rng = make_rng(n);
+        double side = 1000 * std::sqrt((double)n);
+        std::uniform_real_distribution<double> unit(0, side);
+        for (std::size_t i = 0; i < n; i++)
+            space->create_object("star", 1, {}).pos(unit(rng), unit(rng));
+        for (std::size_t i = 0; i < std::max<std::size_t>(n / 100, 1); i++)
+            space->create_object("probe", 1, {}).pos(unit(rng), unit(rng));
+
+        return space;
+    }
+
+    // n colliding disks covering about a fifth of a square, moving in random directions
+    static std::unique_ptr<physics_space> make_gas(std::size_t n, std::size_t threads)
+    {
+        auto space = std::make_unique<physics_space>(1, 1);
+        space->set_threads(threads);
+        space->create_class<movement::verlet_controller>("disk").collide(0.9).build();
+
+        auto rng = make_rng(n);
+        double side = 3 * std::sqrt((double)n);
+        std::uniform_real_distribution<double> unit(0, side);
+        std::uniform_real_distribution<double> speed(-1, 1);
+        for (std::size_t i = 0; i < n; i++)
+            space->create_object("disk", 1, {}).radius(0.8).pos(unit(rng), unit(rng)).vel(speed(rng), speed(rng));
+
+        return space;
+    }
+
+    // a square cloth of about n nodes of unit mass joined to their right and lower neighbors and across both
+    // diagonals, so that it resists shear, stretched by `stretch` and held at its top corners
+    template <typename C = movement::verlet_controller>
+    static std::unique_ptr<physics_space> make_cloth(std::size_t n, std::size_t threads, double stiffness,
+                                                     double stretch = 1.1, double gravity = 0)
+    {
+        auto space = std::make_unique<physics_space>(1, 1);
+        space->set_threads(threads);
+        space->create_class<movement::fixed_controller>("pin").build();
+        auto& node = space->create_class<C>("node");
+        if (gravity != 0)
+            node.const_acc(0, gravity);
+        node.build();
+
+        std::size_t side = std::max<std::size_t>((std::size_t)std::sqrt((double)n), 2);
+        std::vector<object*> nodes;
+        for (std::size_t y = 0; y < side; y++)
+        {
+            for (std::size_t x = 0; x < side; x++)
+            {
+                bool pin = y == 0 && (x == 0 || x + 1 == side);
+                nodes.push_back(&space->create_object(pin ? "pin" : "node", 1, {}).pos(stretch * x, stretch * y).get());
+            }
+        }
+
+        auto& springs = space->springs();
+        for (std::size_t y = 0; y < side; y++)
+        {
+            for (std::size_t x = 0; x < side; x++)
+            {
+                if (x + 1 < side)
+                    springs.add(*nodes[y * side + x], *nodes[y * side + x + 1], sf::Color::White, stiffness, 1);
+                if (y + 1 < side)
+                    springs.add(*nodes[y * side + x], *nodes[(y + 1) * side + x], sf::Color::White, stiffness, 1);
+                if (x + 1 < side && y + 1 < side)
+                {
+                    springs.add(*nodes[y * side + x], *nodes[(y + 1) * side + x + 1], sf::Color::White, stiffness,
+                                std::numbers::sqrt2);
+                    springs.add(*nodes[y * side + x + 1], *nodes[(y + 1) * side + x], sf::Color::White, stiffness,
+                                std::numbers::sqrt2);
+                }
+            }
+        }
+
+        return space;
+    }
+
+    static double seconds(const std::function<void()>& fn)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        fn();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    }
+
+    static void bench_steps(runner& r, std::size_t max_bodies, std::size_t threads)
+    {
+        for (auto n : SCENE_SIZES)
+        {
+            if (n > max_bodies)
+                break;
+
+            std::string bh = fmt::format("step/gravity_bh/n={}/threads={}", n, threads);
+            if (r.enabled(bh))
+            {
+                auto space = make_cloud(n, 0.5, threads);
+                r.run(bh, n, [&] { space->step(DT); });
+            }
+
+            std::string direct = fmt::format("step/gravity_direct/n={}/threads={}", n, threads);
+            if (n <= MAX_DIRECT && r.enabled(direct))
+            {
+                auto space = make_cloud(n, 0, threads);
+                r.run(direct, n, [&] { space->step(DT); });
+            }
+
+            std::string cutoff = fmt::format("step/cutoff_grid/n={}/threads={}", n, threads);
+            if (r.enabled(cutoff))
+            {
+                auto space = make_particles(n, threads, 0);
+                r.run(cutoff, n, [&] { space->step(DT); });
+            }
+
+            std::string lists = fmt::format("step/cutoff_lists/n={}/threads={}", n, threads);
+            if (r.enabled(lists))
+            {
+                auto space = make_particles(n, threads, 0.5);
+                r.run(lists, n, [&] { space->step(DT); });
+            }
+
+            std::string stars = fmt::format("step/fixed_sources/n={}/threads={}", n, threads);
+            if (n <= MAX_DIRECT && r.enabled(stars))
+            {
+                auto space = make_star_field(n, threads);
+                r.run(stars, n, [&] { space->step(DT); });
+            }
+
+            std::string gas = fmt::format("step/collisions/n={}/threads={}", n, threads);
+            if (r.enabled(gas))
+            {
+                auto space = make_gas(n, threads);
+                r.run(gas, n, [&] { space->step(10 * DT); });
+            }
+
+            std::string cloth = fmt::format("step/springs/n={}/threads={}", n, threads);
+            if (r.enabled(cloth))
+            {
+                auto space = make_cloth(n, threads, 100);
+                r.run(cloth, n, [&] { space->step(DT); });
+            }
+
+            // integration and the store round trip on their own
+            std::string free = fmt::format("step/no_forces/n={}/threads={}", n, threads);
+            if (r.enabled(free))
+            {
+                auto space = make_cloud(n, 0, threads, false);
+                r.run(free, n, [&] { space->step(DT); });
+            }
+        }
+    }
+
+    // median wall time of a step over `reps` steps
+    static double median_step(physics_space& space, std::size_t reps)
+    {
+        std::vector<double> t;
+        for (std::size_t i = 0; i < reps; i++)
+            t.push_back(seconds([&] { space.step(DT); }));
+        std::sort(t.begin(), t.end());
+        return t[t.size() / 2];
+    }
+
+    // accuracy of the tree against the direct sum, from the accelerations after one step from the same state
+    static void bench_tree_accuracy(runner& r, std::size_t max_bodies, std::size_t threads)
+    {
+        std::size_t n = std::min<std::size_t>(MAX_DIRECT, max_bodies);
+        std::vector<vec2d> ref;
+        double direct_time = 0;
+
+        for (double theta : {0.3, 0.5, 0.8, 1.2})
+        {
+            std::string name = fmt::format("bh_vs_direct/n={}/theta={}/threads={}", n, theta, threads);
+            if (!r.enabled(name))
+                continue;
+
+            if (ref.empty())
+            {
+                auto direct = make_cloud(n, 0, threads);
+                direct->step(DT);
+                ref.assign(direct->get_store().acc.begin(), direct->get_store().acc.end());
+                direct_time = median_step(*direct, 3);
+            }
+
+            auto tree = make_cloud(n, theta, threads);
+            tree->step(DT);
+
+            const object_store& approx = tree->get_store();
+            double err = 0;
+            double norm = 0;
+            for (std::size_t i = 0; i < n; i++)
+            {
+                vec2d d = approx.acc[i] - ref[i];
+                err += d.dot(d);
+                norm += ref[i].dot(ref[i]);
+            }
+
+            double tree_time = median_step(*tree, 3);
+
+            result res;
+            res.name = name;
+            res.iterations = 1;
+            res.repetitions = 3;
+            res.ns_median = res.ns_min = tree_time * 1e9;
+            res.items = n;
+            res.counters = {{"rms_rel_error", std::sqrt(err / norm)}, {"speedup", direct_time / tree_time}};
+            r.record(std::move(res));
+        }
+    }
+
+    static void bench_threads(runner& r, std::size_t max_bodies)
+    {
+        std::size_t n = std::min<std::size_t>(100000, max_bodies);
+        std::size_t hw = std::max(std::thread::hardware_concurrency(), 1u);
+
+        double single = 0;
+        for (std::size_t threads = 1;; threads = std::min(threads * 2, hw))
+        {
+            std::string name = fmt::format("threads/gravity_bh/n={}/threads={}", n, threads);
+            if (r.enabled(name))
+            {
+                auto space = make_cloud(n, 0.5, threads);
+                space->step(DT);
+                double t = median_step(*space, 5);
+                if (threads == 1)
+                    single = t;
+
+                result res;
+                res.name = name;
+                res.iterations = 1;
+                res.repetitions = 5;
+                res.ns_median = res.ns_min = t * 1e9;
+                res.items = n;
+                if (single > 0)
+                    res.counters = {{"speedup", single / t}, {"efficiency", single / t / threads}};
+                r.record(std::move(res));
+            }
+
+            if (threads == hw)
+                break;
+        }
+    }
+
+    // a heavy sun with light planets on circular orbits, for integrator energy drift
+    template <typename C>
+    static std::unique_ptr<physics_space> make_orbits()
+    {
+        auto space = std::make_unique<physics_space>(1, 1);
+        space->create_class<C>("body").gravity(1).build();
+
+        constexpr double SUN = 1000;
+        space->create_object("body", SUN, {});
+        for (std::size_t i = 0; i < 8; i++)
+        {
+            double r = 50 * (i + 1);
+            double a = 0.7 * i;
+            double v = std::sqrt(SUN / r);
+            space->create_object("body", 1e-3, {})
+                .pos(r * std::cos(a), r * std::sin(a))
+                .vel(-v * std::sin(a), v * std::cos(a));
+        }
+
+        return space;
+    }
+
+    static double energy(const object_store& s)
+    {
+        double e = 0;
+        for (std::size_t i = 0; i < s.size(); i++)
+        {
+            e += 0.5 * s.mass[i] * s.vel[i].dot(s.vel[i]);
+            for (std::size_t j = i + 1; j < s.size(); j++)
+                e -= s.mass[i] * s.mass[j] / (s.pos[i] - s.pos[j]).magnitude();
+        }
+        return e;
+    }
+
+    // Max |dE / E| over ten orbits of the innermost planet, against the wall time the steps took. The varying runs
+    // draw every step from [dt / 2, 3 dt / 2], like the wall clock does between frames.
+    template <typename C>
+    static void bench_drift(runner& r, const std::string& controller)
+    {
+        constexpr double DURATION = 700;
+
+        struct config
+        {
+            double dt;
+            bool varying;
+        };
+
+        for (auto [dt, varying] : {config{0.3, false}, config{0.1, false}, config{0.03, false}, config{0.01, false},
+                                   config{0.1, true}, config{0.01, true}})
+        {
+            std::string name = fmt::format("energy_drift/{}/dt={}{}", controller, dt, varying ? "/varying" : "");
+            if (!r.enabled(name))
+                continue;
+
+            auto space = make_orbits<C>();
+            double e0 = energy(space->get_store());
+            double drift = 0;
+            double wall = 0;
+
+            auto rng = make_rng();
+            std::uniform_real_distribution<double> jitter(0.5, 1.5);
+            std::vector<double> dts(100);
+
+            std::size_t steps = DURATION / dt;
+            for (std::size_t done = 0; done < steps;)
+            {
+                std::size_t batch = std::min<std::size_t>(100, steps - done);
+                for (std::size_t i = 0; i < batch; i++)
+                    dts[i] = varying ? dt * jitter(rng) : dt;
+                wall += seconds([&] {
+                    for (std::size_t i = 0; i < batch; i++)
+                        space->step(dts[i]);
+                });
+                done += batch;
+                space->synchronize();
+                drift = std::max(drift, std::abs((energy(space->get_store()) - e0) / e0));
+            }
+
+            result res;
+            res.name = name;
+            res.iterations = steps;
+            res.repetitions = 1;
+            res.ns_median = res.ns_min = wall / steps * 1e9;
+            res.counters = {{"dt", dt}, {"wall_s", wall}, {"energy_drift", drift}};
+            r.record(std::move(res));
+        }
+    }
+
+    // largest relative stretch of any spring of a make_cloth cloth, infinite once it has blown up
+    static double max_strain(const object_store& s)
+    {
+        std::size_t side = (std::size_t)std::sqrt((double)s.size());
+        double ret = 0;
+        for (std::size_t i = 0; i < s.size(); i++)
+        {
+            for (std::size_t j : {i + 1, i + side})
+            {
+                if (j >= s.size() || (j == i + 1 && j % side == 0))
+                    continue;
+                double len = (s.pos[i] - s.pos[j]).magnitude();
+                ret = std::isfinite(len) ? std::max(ret, std::abs(len - 1)) : INFINITY;
+            }
+        }
+        return ret;
+    }
+
+    // Wall time to simulate ten seconds of a stiff 100x100 cloth falling from its top corners under gravity.
+    // Explicit springs need a step below about 2 / sqrt(12 k / m) and blow up past it, implicit ones take a frame
+    // at a time.
+    static void bench_cloth(runner& r, std::size_t threads)
+    {
+        constexpr double DURATION = 10;
+        constexpr double STIFFNESS = 1e6;
+        constexpr double GRAVITY = 10;
+
+        struct config
+        {
+            const char* name;
+            bool implicit;
+            double dt;
+        };
+
+        for (auto [kind, implicit, dt] : {config{"explicit", false, 5e-4}, config{"explicit", false, 1.0 / 60},
+                                          config{"implicit", true, 1.0 / 60}, config{"implicit", true, 1.0 / 30}})
+        {
+            std::string name = fmt::format("cloth/{}/n=10000/dt={:.4f}/threads={}", kind, dt, threads);
+            if (!r.enabled(name))
+                continue;
+
+            std::unique_ptr<physics_space> space;
+            if (implicit)
+                space = make_cloth<movement::euler_controller>(10000, threads, STIFFNESS, 1, GRAVITY);
+            else
+                space = make_cloth<movement::verlet_controller>(10000, threads, STIFFNESS, 1, GRAVITY);
+            space->springs().set_implicit(implicit);
+
+            std::size_t steps = std::lround(DURATION / dt);
+            std::size_t iterations = 0;
+            double wall = seconds([&] {
+                for (std::size_t i = 0; i < steps; i++)
+                {
+                    space->step(dt);
+                    iterations += space->springs().last_iterations();
+                }
+            });
+
+            result res;
+            res.name = name;
+            res.iterations = steps;
+            res.repetitions = 1;
+            res.ns_median = res.ns_min = wall / steps * 1e9;
+            res.items = 10000;
+            res.counters = {{"dt", dt},
+                            {"wall_s", wall},
+                            {"max_strain", max_strain(space->get_store())},
+                            {"cg_iterations_per_step", (double)iterations / steps}};
+            r.record(std::move(res));
+        }
+    }
+
+    // Disks of make_gas bouncing off a lattice of fixed posts. Contacts must neither push nor bounce the posts, whose
+    // controller ignores forces, so their largest displacement stays 0.
+    static void bench_fixed_posts(runner& r, std::size_t threads)
+    {
+        constexpr std::size_t N = 1000;
+        constexpr std::size_t STEPS = 1000;
+
+        std::string name = fmt::format("collide/fixed_posts/n={}/threads={}", N, threads);
+        if (!r.enabled(name))
+            return;
+
+        auto space = make_gas(N, threads);
+        space->create_class<movement::fixed_controller>("post").collide(0.9).build();
+        double side = 3 * std::sqrt((double)N);
+        std::vector<std::size_t> posts;
+        std::vector<vec2d> start;
+        for (double x = 0; x < side; x += 8)
+        {
+            for (double y = 0; y < side; y += 8)
+            {
+                posts.push_back(space->get_store().size());
+                start.push_back({x, y});
+                space->create_object("post", 1, {}).radius(2).pos(x, y);
+            }
+        }
+
+        double wall = seconds([&] {
+            for (std::size_t i = 0; i < STEPS; i++)
+                space->step(10 * DT);
+        });
+
+        double moved = 0;
+        for (std::size_t k = 0; k < posts.size(); k++)
+            moved = std::max(moved, (space->get_store().pos[posts[k]] - start[k]).magnitude());
+
+        result res;
+        res.name = name;
+        res.iterations = STEPS;
+        res.repetitions = 1;
+        res.ns_median = res.ns_min = wall / STEPS * 1e9;
+        res.items = N + posts.size();
+        res.counters = {{"posts", (double)posts.size()}, {"max_post_displacement", moved}};
+        r.record(std::move(res));
+    }
+
+    // the raw bandwidth of publishing a step's state
+    static void bench_store(runner& r, std::size_t max_bodies)
+    {
+        std::size_t n = max_bodies;
+        std::string name = fmt::format("store/commit/n={}", n);
+        if (!r.enabled(name))
+            return;
+
+        object_store store;
+        store.reserve(n);
+        for (std::size_t i = 0; i < n; i++)
+            store.push(1, 0);
+
+        r.run(name, n, [&] {
+            store.commit();
+            keep(store.pos.data());
+        });
+    }
+
+    void run_scenes(runner& r, std::size_t max_bodies, std::size_t threads)
+    {
+        bench_steps(r, max_bodies, threads);
+        bench_tree_accuracy(r, max_bodies, threads);
+        bench_threads(r, max_bodies);
+
+        bench_drift<movement::default_controller>(r, "default");
+        bench_drift<movement::verlet_controller>(r, "verlet");
+        bench_drift<movement::yoshida4_controller>(r, "yoshida4");
+        bench_drift<movement::rk4_controller>(r, "rk4");
+
+        bench_cloth(r, threads);
+        bench_fixed_posts(r, threads);
+        bench_store(r, max_bodies);
+    }
+} // namespace phy::bench
@@ -0,0 +1,102 @@
+#ifndef __PHY_COLLIDER_H__
+#define __PHY_COLLIDER_H__
+#include <cmath>
+#include <cstdint>
+#include <object_store.h>
+#include <util/thread_pool.h>
+#include <vector>
+
+namespace phy
+{
+    // Finds overlapping circles with sort and sweep on x and pushes them apart with an impulse along the line
+    // between their centers. The members stay sorted from one step to the next, so the insertion sort that brings
+    // them back in order costs little more than a pass over them while they move slowly.
+    //
+    // A single sweep over a wide scene compares every body with the whole column of bodies above and below it, so
+    // the members are dealt into horizontal bands as high as the largest diameter, keeping their order, and each
+    // band is swept on its own. Bands are hashed into buckets like the cells of a cell_grid.
+    class collider
+    {
+        struct box
+        {
+            double lo;
+            double hi;
+            vec2d pos;
+            double radius;
+            double restitution;
+            // immovable boxes act as if their mass was infinite
+            bool movable;
+            std::size_t id;
+            // lowest band the box reaches into
+            std::int64_t band;
+        };
+
+        struct contact
+        {
+            std::size_t a;
+            std::size_t b;
+        };
+
+        // sorted by lo after sort()
+        std::vector<box> boxes;
+        bool sorted = false;
+        double inv_band = 0;
+
+        // entries[start[k], start[k + 1]) are the indices into boxes that reach into a band of bucket k, by lo
+        std::vector<std::uint32_t> entries;
+        std::vector<std::uint32_t> start;
+        std::vector<std::uint32_t> cursor;
+        // the buckets of the lowest and, if it is another one, the highest band of every box
+        std::vector<std::uint32_t> low;
+        std::vector<std::uint32_t> high;
+        std::size_t mask = 0;
+
+        // one list per part of the sweep, in order
+        std::vector<std::vector<contact>> contacts;
+
+        inline std::int64_t band_of(double y) const
+        {
+            constexpr double LIMIT = 1e15;
+            double b = y * inv_band;
+            if (!(std::abs(b) < LIMIT))
+                b = b > 0 ? LIMIT : -LIMIT;
+            // floor without the library call
+            auto ret = (std::int64_t)b;
+            return ret > b ? ret - 1 : ret;
+        }
+
+        inline std::size_t bucket(std::int64_t band) const
+        {
+            std::uint64_t h = (std::uint64_t)band * 0x9e3779b97f4a7c15ull;
+            return (h ^ h >> 29) & mask;
+        }
+
+    public:
+        inline void clear()
+        {
+            boxes.clear();
+            sorted = false;
+        }
+
+        // restitution is 1 for elastic and 0 for perfectly inelastic collisions, a pair uses the smaller of its two.
+        // Bodies whose controller ignores forces are not movable, contacts neither push nor bounce them.
+        inline void add(std::size_t id, double restitution, bool movable = true)
+        {
+            boxes.push_back({0, 0, {}, 0, restitution, movable, id, 0});
+            sorted = false;
+        }
+
+        constexpr std::size_t size() const { return boxes.size(); }
+
+        // reads the current positions and radii and restores the order
+        void sort(const object_store& store);
+        // deals the sorted boxes into their bands
+        void bin();
+        // collects the overlapping pairs, returns how many there are
+        std::size_t sweep(thread_pool& pool);
+        // separates every overlapping pair and exchanges the impulse of those that approach each other
+        void respond(object_store& store) const;
+    };
+} // namespace phy
+
+#endif
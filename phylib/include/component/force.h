@@ -1,5 +1,8 @@
 #ifndef __PHY_FORCES_H__
 #define __PHY_FORCES_H__
+#include <cmath>
+#include <optional>
+#include <util/diagnostics.h>
 #include <util/vec.h>
 
 namespace phy
@@ -8,6 +11,7 @@ namespace phy
 
     namespace forces
     {
+        // An interaction force: `that` exerts compute_force(that, rhs) on `rhs`, evaluated for every pair of objects
         class force
         {
         public:
@@ -15,28 +19,132 @@ namespace phy
             virtual ~force() = default;
         };
 
-        class gravity final : public force
+        // A force that an object feels on its own, such as a uniform field or drag. These are evaluated once per object
+        // instead of once per pair.
+        class body_force : public force
+        {
+        public:
+            virtual vec2d compute_force(object& that) = 0;
+            virtual vec2d compute_force(object& that, object& rhs) override;
+        };
+
+        // -constant * m_src * m_tgt / r^power along the displacement, where r is clamped to at least min_dist. With
+        // softening, the magnitude is constant * m_src * m_tgt * r / (r^2 + softening^2)^((power + 1) / 2) instead and
+        // min_dist is not used.
+        struct power_law
+        {
+            double constant;
+            double power;
+            double min_dist;
+            double softening = 0;
+        };
+
+        // A force that only depends on the displacement and masses of the two bodies. Since it never looks at anything
+        // else, it can also be evaluated against the aggregate mass of a distant cluster of bodies.
+        class field_force : public force
+        {
+        public:
+            // `disp` is the position of the body being acted upon relative to the source of the field
+            virtual vec2d field(vec2d disp, double src_mass, double tgt_mass) const = 0;
+            virtual vec2d compute_force(object& that, object& rhs) override;
+
+            // true if field(-disp, b, a) == -field(disp, a, b), i.e. two bodies of the same class exert equal and
+            // opposite forces on each other and the pair only needs to be evaluated once
+            virtual bool antisymmetric() const { return false; }
+
+            // forces that can be written as a power_law are eligible for the vectorized direct sum
+            virtual std::optional<power_law> as_power_law() const { return std::nullopt; }
+
+            // distance at and beyond which field() is exactly zero, 0 if the force has unlimited range
+            virtual double cutoff() const { return 0; }
+        };
+
+        // The built-in forces below expose their math through non-virtual inline `eval` members, which is what the
+        // fused per-class pipelines call. The virtual entry points forward to them.
+
+        class gravity final : public field_force
         {
             const double constant;
 
         public:
             constexpr gravity(double G) : constant(G) {}
 
-            virtual vec2d compute_force(object& that, object& rhs) override;
+            inline vec2d eval(vec2d dist, double src_mass, double tgt_mass) const
+            {
+                if (dist.magnitude() < 0.1)
+                {
+                    diagnostics::count(diagnostics::CLOSE_ENCOUNTER);
+                    dist.magnitude(0.1);
+                }
+
+                double r_sq = dist.dot(dist);
+                return -dist.normalize() * constant * src_mass * tgt_mass / r_sq;
+            }
+
+            virtual vec2d field(vec2d disp, double src_mass, double tgt_mass) const override;
+            virtual bool antisymmetric() const override { return true; }
+            virtual std::optional<power_law> as_power_law() const override { return power_law{constant, 2, 0.1}; }
         };
 
-        class simple_field final : public force
+        // optionally cut off at `range`, which lets the engine only evaluate it between nearby bodies
+        class simple_field final : public field_force
         {
             const double constant;
             const double power;
+            const double range;
 
         public:
-            constexpr simple_field(double G, double power) : constant(G), power(power) {}
+            constexpr simple_field(double G, double power, double range = 0) : constant(G), power(power), range(range)
+            {
+            }
 
-            virtual vec2d compute_force(object& that, object& rhs) override;
+            inline vec2d eval(vec2d dist, double src_mass, double tgt_mass) const
+            {
+                double r_sq = dist.dot(dist);
+                if (range > 0 && r_sq >= range * range)
+                    return vec2d();
+
+                double r_sqrt = invsqrt(r_sq);
+                return -dist.normalize() * constant * src_mass * tgt_mass * std::pow(r_sqrt, power);
+            }
+
+            virtual vec2d field(vec2d disp, double src_mass, double tgt_mass) const override;
+            virtual bool antisymmetric() const override { return true; }
+            virtual double cutoff() const override { return range; }
+            // the vectorized kernel has no notion of a cutoff
+            virtual std::optional<power_law> as_power_law() const override
+            {
+                if (range > 0)
+                    return std::nullopt;
+                return power_law{constant, power, 0};
+            }
         };
 
-        class force_drag final : public force
+        // Gravity with Plummer softening, -G * m_src * m_tgt * disp / (r^2 + eps^2)^1.5. It is smooth through close
+        // encounters instead of clamping them, and has no branches.
+        class softened_gravity final : public field_force
+        {
+            const double constant;
+            const double eps;
+
+        public:
+            constexpr softened_gravity(double G, double eps) : constant(G), eps(eps) {}
+
+            inline vec2d eval(vec2d dist, double src_mass, double tgt_mass) const
+            {
+                double inv = 1 / std::sqrt(dist.dot(dist) + eps * eps);
+                return dist * (-constant * src_mass * tgt_mass * inv * inv * inv);
+            }
+
+            virtual vec2d field(vec2d disp, double src_mass, double tgt_mass) const override;
+            virtual bool antisymmetric() const override { return true; }
+            virtual std::optional<power_law> as_power_law() const override
+            {
+                return power_law{constant, 2, 0, eps};
+            }
+        };
+
+        class force_drag final : public body_force
         {
             const double drag_const;
             const double power;
@@ -44,17 +152,26 @@ namespace phy
         public:
             constexpr force_drag(double drag_const, double power) : drag_const(drag_const), power(power) {}
 
-            virtual vec2d compute_force(object& that, object& rhs) override;
+            inline vec2d eval(double, const vec2d& vel) const
+            {
+                return -vel.normalize() * std::pow(vel.magnitude(), power) * drag_const;
+            }
+
+            using body_force::compute_force;
+            virtual vec2d compute_force(object& that) override;
         };
 
-        class const_acc final : public force
+        class const_acc final : public body_force
         {
             vec2d acc;
 
         public:
             const_acc(vec2d acc) : acc(acc) {}
 
-            virtual vec2d compute_force(object& that, object& rhs) override;
+            inline vec2d eval(double mass, const vec2d&) const { return acc * mass; }
+
+            using body_force::compute_force;
+            virtual vec2d compute_force(object& that) override;
         };
     } // namespace forces
 } // namespace phy
@@ -0,0 +1,184 @@
+#ifndef __PHY_COMPONENT_FORCE_PIPELINE_H__
+#define __PHY_COMPONENT_FORCE_PIPELINE_H__
+#include <algorithm>
+#include <component/force.h>
+#include <memory>
+#include <object_store.h>
+#include <tuple>
+#include <util/quadtree.h>
+#include <vector>
+
+namespace phy
+{
+    class object;
+
+    namespace forces
+    {
+        // The body forces of one class, applied to a batch of its objects at once
+        class body_pipeline
+        {
+        public:
+            // adds the body force on every object in ids[0, n) to out[id]
+            virtual void accumulate(const object_store& store, const std::unique_ptr<object>* objects,
+                                    const std::size_t* ids, std::size_t n, vec2d* out) const = 0;
+            virtual ~body_pipeline() = default;
+        };
+
+        // The field forces of one class, evaluated between a target and the members of the class
+        class field_pipeline
+        {
+        public:
+            // force on `target` from every member in ids[0, n) other than itself
+            virtual vec2d sum(const object_store& store, const std::size_t* ids, std::size_t n,
+                              std::size_t target) const = 0;
+
+            // Evaluates every pair (k, l), k < l, with k in [k0, k1) and l in [l0, l1) once, adding the force on
+            // member l to acc[l] and its reaction to acc[k]. Only valid for antisymmetric forces.
+            virtual void scatter(const object_store& store, const std::vector<std::size_t>& members, std::size_t k0,
+                                 std::size_t k1, std::size_t l0, std::size_t l1, vec2d* acc) const = 0;
+
+            // force on `target` from the members indexed by `tree`
+            virtual vec2d walk(const object_store& store, const quadtree& tree, double theta,
+                               std::size_t target) const = 0;
+
+            virtual ~field_pipeline() = default;
+        };
+
+        // A fixed set of built-in body forces, summed inline
+        template <typename... F>
+        class fused_body_pipeline final : public body_pipeline
+        {
+            std::tuple<F...> forces;
+
+        public:
+            fused_body_pipeline(const F&... f) : forces(f...) {}
+
+            virtual void accumulate(const object_store& store, const std::unique_ptr<object>*, const std::size_t* ids,
+                                    std::size_t n, vec2d* out) const override
+            {
+                for (std::size_t k = 0; k < n; k++)
+                {
+                    std::size_t i = ids[k];
+                    double mass = store.mass[i];
+                    const vec2d& vel = store.vel[i];
+
+                    vec2d force;
+                    std::apply([&](const auto&... f) { ((force += f.eval(mass, vel)), ...); }, forces);
+                    out[i] += force;
+                }
+            }
+        };
+
+        class virtual_body_pipeline final : public body_pipeline
+        {
+            std::vector<body_force*> forces;
+
+        public:
+            virtual_body_pipeline(std::vector<body_force*> forces) : forces(std::move(forces)) {}
+
+            virtual void accumulate(const object_store& store, const std::unique_ptr<object>* objects,
+                                    const std::size_t* ids, std::size_t n, vec2d* out) const override;
+        };
+
+        // A fixed set of built-in field forces, summed inline
+        template <typename... F>
+        struct fused_laws
+        {
+            std::tuple<F...> laws;
+
+            inline vec2d operator()(const vec2d& disp, double src_mass, double tgt_mass) const
+            {
+                vec2d force;
+                std::apply([&](const auto&... f) { ((force += f.eval(disp, src_mass, tgt_mass)), ...); }, laws);
+                return force;
+            }
+        };
+
+        struct virtual_laws
+        {
+            std::vector<const field_force*> laws;
+
+            inline vec2d operator()(const vec2d& disp, double src_mass, double tgt_mass) const
+            {
+                vec2d force;
+                for (auto law : laws)
+                    force += law->field(disp, src_mass, tgt_mass);
+                return force;
+            }
+        };
+
+        template <typename L>
+        class basic_field_pipeline final : public field_pipeline
+        {
+            L law;
+
+        public:
+            basic_field_pipeline(L law) : law(std::move(law)) {}
+
+            virtual vec2d sum(const object_store& store, const std::size_t* ids, std::size_t n,
+                              std::size_t target) const override
+            {
+                vec2d force;
+                const vec2d& pos = store.pos[target];
+                double mass = store.mass[target];
+
+                for (std::size_t k = 0; k < n; k++)
+                {
+                    std::size_t j = ids[k];
+                    if (j != target)
+                        force += law(pos - store.pos[j], store.mass[j], mass);
+                }
+
+                return force;
+            }
+
+            virtual void scatter(const object_store& store, const std::vector<std::size_t>& members, std::size_t k0,
+                                 std::size_t k1, std::size_t l0, std::size_t l1, vec2d* acc) const override
+            {
+                for (std::size_t k = k0; k < k1; k++)
+                {
+                    std::size_t src = members[k];
+                    const vec2d& pos = store.pos[src];
+                    double mass = store.mass[src];
+                    vec2d sum;
+
+                    for (std::size_t l = std::max(l0, k + 1); l < l1; l++)
+                    {
+                        std::size_t tgt = members[l];
+                        vec2d force = law(store.pos[tgt] - pos, mass, store.mass[tgt]);
+                        acc[l] += force;
+                        sum -= force;
+                    }
+
+                    acc[k] += sum;
+                }
+            }
+
+            virtual vec2d walk(const object_store& store, const quadtree& tree, double theta,
+                               std::size_t target) const override
+            {
+                vec2d force;
+                const vec2d& pos = store.pos[target];
+                double mass = store.mass[target];
+
+                tree.walk(
+                    pos, theta,
+                    [&](std::size_t id, const vec2d& src, double src_mass) {
+                        if (id != target)
+                            force += law(pos - src, src_mass, mass);
+                    },
+                    [&](const vec2d& com, double src_mass) { force += law(pos - com, src_mass, mass); });
+
+                return force;
+            }
+        };
+
+        // Built-in combinations get a pipeline with every force inlined into its loops, anything else falls back to
+        // one virtual call per force. Returns null if there is nothing to evaluate, make_field_pipeline also returns
+        // null if any of the forces is not a field force.
+        std::unique_ptr<body_pipeline> make_body_pipeline(const std::vector<std::unique_ptr<body_force>>& forces);
+        std::unique_ptr<field_pipeline> make_field_pipeline(const std::vector<std::unique_ptr<force>>& forces);
+    } // namespace forces
+} // namespace phy
+
+#endif
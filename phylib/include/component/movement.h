@@ -1,5 +1,6 @@
 #ifndef __PHY_COMPONENT_MOVEMENT_H__
 #define __PHY_COMPONENT_MOVEMENT_H__
+#include <cstddef>
 #include <util/vec.h>
 
 namespace phy
@@ -10,23 +11,76 @@ namespace phy
         class movement_controller
         {
         public:
-            virtual void update(object& obj, float dt, const vec2d& vec) = 0;
+            // number of force evaluations per step
+            virtual std::size_t stages() const { return 1; }
+            // controllers that ignore the force they are handed are never the target of a force sum
+            virtual bool consumes_forces() const { return true; }
+            // controllers that keep per object state across stages in the scratch columns of the object_store
+            virtual bool uses_scratch() const { return false; }
+
+            // Advances `obj` through stage `stage` of a step of length dt. `vec` is the force evaluated at the state
+            // the previous stage left behind, the result is written to the new_* state.
+            virtual void update(object& obj, float dt, const vec2d& vec, std::size_t stage) = 0;
+            // Settles the last kick of the previous step, of length dt, with the force `vec` at the current state.
+            // Called before the first stage of every step but an object's first.
+            virtual void settle(object&, float, const vec2d&) {}
             virtual ~movement_controller() = default;
         };
 
         class default_controller : public movement_controller
         {
         public:
-            virtual void update(object& obj, float dt, const vec2d& vec);
+            virtual void update(object& obj, float dt, const vec2d& vec, std::size_t stage) override;
             virtual ~default_controller() = default;
         };
 
         class fixed_controller : public movement_controller
         {
         public:
-            virtual void update(object& obj, float dt, const vec2d& vec);
+            virtual bool consumes_forces() const override { return false; }
+            virtual void update(object& obj, float dt, const vec2d& vec, std::size_t stage) override;
             virtual ~fixed_controller() = default;
         };
+
+        // Semi-implicit Euler: kicks the velocity by the whole step, then drifts with the new velocity. First order and
+        // symplectic, and the integrator implicit springs are exact for
+        class euler_controller : public movement_controller
+        {
+        public:
+            virtual void update(object& obj, float dt, const vec2d& vec, std::size_t stage) override;
+            virtual ~euler_controller() = default;
+        };
+
+        // Kick-drift-kick leapfrog, second order and symplectic. The closing kick shares the force evaluation of the
+        // opening kick of the next step.
+        class verlet_controller : public movement_controller
+        {
+        public:
+            virtual void update(object& obj, float dt, const vec2d& vec, std::size_t stage) override;
+            virtual void settle(object& obj, float dt, const vec2d& vec) override;
+            virtual ~verlet_controller() = default;
+        };
+
+        // Yoshida's fourth order symplectic integrator, three leapfrog steps with weights w1, w0, w1. Like
+        // verlet_controller, the last kick shares the first force evaluation of the next step.
+        class yoshida4_controller : public movement_controller
+        {
+        public:
+            virtual std::size_t stages() const override { return 3; }
+            virtual void update(object& obj, float dt, const vec2d& vec, std::size_t stage) override;
+            virtual void settle(object& obj, float dt, const vec2d& vec) override;
+            virtual ~yoshida4_controller() = default;
+        };
+
+        // Classic fourth order Runge-Kutta, accurate but not symplectic
+        class rk4_controller : public movement_controller
+        {
+        public:
+            virtual std::size_t stages() const override { return 4; }
+            virtual bool uses_scratch() const override { return true; }
+            virtual void update(object& obj, float dt, const vec2d& vec, std::size_t stage) override;
+            virtual ~rk4_controller() = default;
+        };
     } // namespace movement
 } // namespace phy
 
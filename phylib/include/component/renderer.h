@@ -7,6 +7,7 @@
 namespace phy
 {
     class object;
+    class object_store;
 
     namespace render
     {
@@ -14,7 +15,19 @@ namespace phy
         {
         public:
             virtual void init(object& that, const named_value_map& map) = 0;
+            // called once per displayed frame, before render_phase
             virtual void update_phase(object& that) = 0;
+
+            // Renderers that keep a history of the object between frames, like trails, return true here and record
+            // it in sample_phase, which is called at the history interval of the space or once per frame. `time` is
+            // the simulated time of the sample.
+            virtual bool samples_history() const { return false; }
+            virtual void sample_phase(const object&, [[maybe_unused]] double time) {}
+
+            // Renderers that draw every object of their class in one go return true here. They still see each object
+            // through init, but are skipped by the per object phases and draw the whole class in draw_batch instead.
+            virtual bool batched() const { return false; }
+            virtual void draw_batch(const object_store&, sf::RenderTarget&, sf::RenderStates) {}
             virtual void render_phase(const object& that, sf::RenderTarget& tgt, sf::RenderStates state) = 0;
             virtual ~renderer() = default;
         };
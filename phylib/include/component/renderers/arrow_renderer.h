@@ -1,6 +1,7 @@
 #ifndef __PHY_COMPONENT_RENDERERS_ARROW_RENDERER_H__
 #define __PHY_COMPONENT_RENDERERS_ARROW_RENDERER_H__
 #include <SFML/Graphics.hpp>
+#include <array>
 #include <component/renderer.h>
 #include <object.h>
 
@@ -17,7 +18,7 @@ namespace phy::render
     {
         double scale;
         indexed_type<sf::ConvexShape> triangle;
-        indexed_type<sf::Vertex> vert;
+        indexed_type<std::array<sf::Vertex, 2>> vert;
 
         constexpr static const char* get_key_name()
         {
@@ -34,7 +35,7 @@ namespace phy::render
         inline static constexpr named_type<sf::Color> COLOR_KEY = get_key_name();
 
         arrow_renderer(const slot_allocator& alloc, double scale)
-            : scale(scale), triangle(alloc_slot<sf::ConvexShape>(alloc)), vert(alloc_slot<sf::Vertex, true>(alloc))
+            : scale(scale), triangle(alloc_slot<sf::ConvexShape>(alloc)), vert(alloc_slot<std::array<sf::Vertex, 2>>(alloc))
         {
         }
 
@@ -42,18 +43,16 @@ namespace phy::render
         {
             const sf::Color& color = COLOR_KEY.at(map);
 
-            sf::ConvexShape* trig = new sf::ConvexShape(3);
-            trig->setPoint(0, {2, 0});
-            trig->setPoint(1, {-2, 0});
-            trig->setPoint(2, {0, 4});
-            trig->setFillColor(color);
+            sf::ConvexShape& trig = *triangle.get(that.get_valuemap());
+            trig.setPointCount(3);
+            trig.setPoint(0, {2, 0});
+            trig.setPoint(1, {-2, 0});
+            trig.setPoint(2, {0, 4});
+            trig.setFillColor(color);
 
-            auto vert = new sf::Vertex[2]();
+            auto& vert = *this->vert.get(that.get_valuemap());
             vert[0].color = color;
             vert[1].color = color;
-
-            triangle.write(that.get_valuemap(), trig);
-            this->vert.write(that.get_valuemap(), vert);
         }
 
         virtual void update_phase(object& that) override
@@ -61,7 +60,7 @@ namespace phy::render
             const vec2d& vec = T == VEL ? that.get_vel() : that.get_acc();
             vec2d result = that.get_pos() + vec * scale;
             auto& triangle = *this->triangle.get(that.get_valuemap());
-            sf::Vertex* v = this->vert.get(that.get_valuemap());
+            auto& v = *this->vert.get(that.get_valuemap());
 
             triangle.setRotation(360 - vec.angle());
             triangle.setPosition(vector_cast<float>(result));
@@ -72,7 +71,7 @@ namespace phy::render
         virtual void render_phase(const object& that, sf::RenderTarget& tgt, sf::RenderStates state) override
         {
             tgt.draw(*triangle.get(that.get_valuemap()), state);
-            tgt.draw(vert.get(that.get_valuemap()), 2, sf::Lines);
+            tgt.draw(vert.get(that.get_valuemap())->data(), 2, sf::Lines);
         }
     };
 
@@ -2,12 +2,16 @@
 #define __PHY_COMPONENT_RENDERERS_CIRCLE_RENDERER_H__
 #include <SFML/Graphics.hpp>
 #include <component/renderer.h>
+#include <vector>
 
 namespace phy::render
 {
+    // Draws every object of a class as a quad textured with a disk, all in a single draw call
     class circle_renderer : public renderer
     {
-        indexed_type<sf::CircleShape> circle;
+        std::vector<std::size_t> ids;
+        std::vector<float> radii;
+        sf::VertexArray quads;
 
     public:
         inline static constexpr named_type<sf::Color> COLOR_KEY = "render_circle_color";
@@ -17,6 +21,8 @@ namespace phy::render
         virtual void init(object& that, const named_value_map& map) override;
         virtual void update_phase(object& that) override;
         virtual void render_phase(const object& that, sf::RenderTarget& tgt, sf::RenderStates state) override;
+        virtual bool batched() const override { return true; }
+        virtual void draw_batch(const object_store& store, sf::RenderTarget& tgt, sf::RenderStates state) override;
         virtual ~circle_renderer() override = default;
     };
 } // namespace phy::render
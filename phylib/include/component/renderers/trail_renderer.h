@@ -1,23 +1,41 @@
 #ifndef __PHY_COMPONENT_RENDERERS_TRAIL_RENDERER_H__
 #define __PHY_COMPONENT_RENDERERS_TRAIL_RENDERER_H__
 #include <SFML/Graphics.hpp>
+#include <boost/circular_buffer.hpp>
 #include <component/renderer.h>
 
 namespace phy::render
 {
+    // A trail of at most `max_points` vertices. When it fills up, the older half is simplified to within `min_dist`
+    // (Douglas-Peucker), and only if that frees too little are the oldest vertices dropped, so memory and drawing cost
+    // stay bounded however long the simulation runs. Vertices older than `max_age` are dropped, 0 keeps them.
     class trail_renderer : public renderer
     {
-        indexed_type<sf::VertexArray> vert;
-        indexed_type<sf::Color> trail_color;
+        struct trail
+        {
+            boost::circular_buffer<sf::Vertex> vert;
+            boost::circular_buffer<double> time;
+            sf::Color color;
+        };
+
+        indexed_type<trail> state;
         double min_dist;
+        std::size_t max_points;
+        double max_age;
+
+        void compact(trail& t) const;
 
     public:
         inline static constexpr named_type<sf::Color> COLOR_KEY = "render_trail_color";
+        static constexpr std::size_t DEFAULT_MAX_POINTS = 4096;
 
-        trail_renderer(const slot_allocator& alloc, double min_dist);
+        trail_renderer(const slot_allocator& alloc, double min_dist, std::size_t max_points = DEFAULT_MAX_POINTS,
+                       double max_age = 0);
 
         virtual void init(object& that, const named_value_map& map) override;
         virtual void update_phase(object& that) override;
+        virtual bool samples_history() const override { return true; }
+        virtual void sample_phase(const object& that, double time) override;
         virtual void render_phase(const object& that, sf::RenderTarget& tgt, sf::RenderStates state) override;
         virtual ~trail_renderer() override = default;
     };
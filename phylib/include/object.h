@@ -5,6 +5,7 @@
 #include <component/renderer.h>
 #include <memory>
 #include <object_class.h>
+#include <object_store.h>
 #include <util/vec.h>
 
 namespace phy
@@ -12,14 +13,8 @@ namespace phy
     class object : public sf::Drawable
     {
     protected:
+        object_store* store;
         std::size_t id;
-        vec2d acc;
-        vec2d vel;
-        vec2d pos;
-        vec2d new_acc;
-        vec2d new_vel;
-        vec2d new_pos;
-        double mass;
 
         const object_class* clazz;
         value_map vmap;
@@ -27,49 +22,55 @@ namespace phy
         friend class physics_space;
         friend class object_class;
 
-        object(double mass, object_class* clazz, const named_value_map& v, std::size_t id);
+        object(object_store& store, double mass, object_class* clazz, const named_value_map& v);
 
     public:
+        // physical radius, the drawn radius if it is not given
+        inline static constexpr named_type<double> RADIUS_KEY = "collision_radius";
+
         object(const object&) = delete;
         object(object&&) = delete;
         const object& operator=(const object&) = delete;
         const object& operator=(object&&) = delete;
 
-        ~object();
-
         // object update phases
         vec2d apply_force(object& obj);
-        void update(double dt, const vec2d& force);
-        void step_time();
+        vec2d apply_body_force();
+        void update(double dt, const vec2d& force, std::size_t stage = 0);
+        void settle(double dt, const vec2d& force);
+        void update_render();
+        void sample_history(double time) const;
         virtual void draw(sf::RenderTarget& t, sf::RenderStates s) const override;
 
-        constexpr const vec2d& get_acc() const { return acc; }
-        constexpr const vec2d& get_vel() const { return vel; }
-        constexpr const vec2d& get_pos() const { return pos; }
-        constexpr const vec2d& get_new_acc() const { return new_acc; }
-        constexpr const vec2d& get_new_vel() const { return new_vel; }
-        constexpr const vec2d& get_new_pos() const { return new_pos; }
-        constexpr double get_mass() const { return mass; }
+        constexpr const vec2d& get_acc() const { return store->acc[id]; }
+        constexpr const vec2d& get_vel() const { return store->vel[id]; }
+        constexpr const vec2d& get_pos() const { return store->pos[id]; }
+        constexpr const vec2d& get_new_acc() const { return store->new_acc[id]; }
+        constexpr const vec2d& get_new_vel() const { return store->new_vel[id]; }
+        constexpr const vec2d& get_new_pos() const { return store->new_pos[id]; }
+        constexpr double get_mass() const { return store->mass[id]; }
+        constexpr double get_radius() const { return store->radius[id]; }
         constexpr std::size_t identifier() const { return id; }
+        constexpr object_store& get_store() const { return *store; }
 
-        constexpr void set_acc(const vec2d& a) { acc = new_acc = a; }
-        constexpr void set_vel(const vec2d& a) { vel = new_vel = a; }
-        constexpr void set_pos(const vec2d& a) { pos = new_pos = a; }
+        constexpr void set_acc(const vec2d& a) { store->acc[id] = store->new_acc[id] = a; }
+        constexpr void set_vel(const vec2d& a) { store->vel[id] = store->new_vel[id] = a; }
+        constexpr void set_pos(const vec2d& a) { store->pos[id] = store->new_pos[id] = a; }
 
-        constexpr void set_new_acc(const vec2d& a) { new_acc = a; }
-        constexpr void set_new_vel(const vec2d& a) { new_vel = a; }
-        constexpr void set_new_pos(const vec2d& a) { new_pos = a; }
+        constexpr void set_new_acc(const vec2d& a) { store->new_acc[id] = a; }
+        constexpr void set_new_vel(const vec2d& a) { store->new_vel[id] = a; }
+        constexpr void set_new_pos(const vec2d& a) { store->new_pos[id] = a; }
 
-        constexpr void set_momentum(const vec2d& a) { set_vel(a / mass); }
+        constexpr void set_momentum(const vec2d& a) { set_vel(a / get_mass()); }
+        constexpr void set_radius(double r) { store->radius[id] = r > 0 ? r : 0; }
 
         constexpr void set_mass(double mass)
         {
             if (mass <= 0)
-                this->mass = mass;
+                store->mass[id] = mass;
         }
 
-        constexpr const std::vector<void*>& get_valuemap() const { return vmap; }
-        constexpr std::vector<void*>& get_valuemap() { return vmap; }
+        constexpr const value_map& get_valuemap() const { return vmap; }
     };
 } // namespace phy
 
@@ -1,8 +1,10 @@
 #ifndef __PHY_OBJECT_CLASS_H__
 #define __PHY_OBJECT_CLASS_H__
 #include <component/force.h>
+#include <component/force_pipeline.h>
 #include <component/movement.h>
 #include <component/renderer.h>
+#include <cstdint>
 #include <memory>
 #include <unordered_map>
 #include <util/obj_class_util.h>
@@ -15,22 +17,63 @@ namespace phy
     class object_class
     {
         std::vector<std::unique_ptr<forces::force>> forces;
+        std::vector<std::unique_ptr<forces::body_force>> body_forces;
+        std::unique_ptr<forces::field_pipeline> field_kernel;
+        std::unique_ptr<forces::body_pipeline> body_kernel;
         std::vector<std::unique_ptr<render::renderer>> renderers;
-        std::vector<void (*)(void*)> deleters;
+        // renderers that run per object, the rest draw the whole class at once
+        std::vector<render::renderer*> object_renderers;
+        std::vector<render::renderer*> batch_renderers;
+        // the renderers that sample history
+        std::vector<render::renderer*> samplers;
+        // the renderer state of every object, one column per slot
+        slot_columns slots;
+        std::size_t rows = 0;
         index_map named_vmap;
         std::unique_ptr<movement::movement_controller> controller;
+        // negative if the class does not collide
+        double restitution = -1;
+        // the interaction group of the class as a bit, and the groups whose forces it feels
+        std::uint64_t group = 1;
+        std::uint64_t feel_mask = ~std::uint64_t(0);
+        std::uint32_t id;
 
         friend class object_class_builder;
         friend class object;
 
         object_class() = default;
 
-        void init_object(object& obj, const named_value_map& vmap) const;
-        void destroy_object(object& obj) const;
+        void init_object(object& obj, const named_value_map& vmap);
 
     public:
         void set_key(object& obj, const char* s) const;
-        constexpr std::size_t vmap_size() const { return deleters.size(); }
+        constexpr std::size_t vmap_size() const { return slots.size(); }
+        // makes room for n more objects without growing the columns one by one
+        void reserve(std::size_t n);
+        constexpr std::uint32_t get_id() const { return id; }
+        inline const movement::movement_controller& get_controller() const { return *controller; }
+        constexpr bool collides() const { return restitution >= 0; }
+        constexpr std::uint64_t get_group() const { return group; }
+        constexpr std::uint64_t get_feel_mask() const { return feel_mask; }
+        // whether objects of this class are moved by the forces of objects of `source`
+        constexpr bool feels(const object_class& source) const { return (feel_mask & source.group) != 0; }
+        constexpr double get_restitution() const { return restitution; }
+        constexpr bool samples_history() const { return !samplers.empty(); }
+        constexpr const std::vector<render::renderer*>& get_batch_renderers() const { return batch_renderers; }
+        // all renderers in the order they were declared
+        constexpr const std::vector<std::unique_ptr<render::renderer>>& get_renderers() const { return renderers; }
+        // forces this class exerts on other objects
+        constexpr const std::vector<std::unique_ptr<forces::force>>& get_forces() const { return forces; }
+        // forces objects of this class feel on their own
+        constexpr const std::vector<std::unique_ptr<forces::body_force>>& get_body_forces() const
+        {
+            return body_forces;
+        }
+
+        // evaluators built from the forces above, null if there is nothing to evaluate; field_kernel is also null if
+        // the class exerts anything other than field forces
+        inline const forces::field_pipeline* get_field_kernel() const { return field_kernel.get(); }
+        inline const forces::body_pipeline* get_body_kernel() const { return body_kernel.get(); }
     };
 } // namespace phy
 
@@ -0,0 +1,47 @@
+#ifndef __PHY_OBJECT_STORE_H__
+#define __PHY_OBJECT_STORE_H__
+#include <cstdint>
+#include <util/aligned.h>
+#include <util/vec.h>
+
+namespace phy
+{
+    // Columnar storage for the kinematic state of every object in a physics_space. Row `i` belongs to the object
+    // with identifier `i`, which is itself only a handle into this store.
+    class object_store
+    {
+    public:
+        aligned_vector<vec2d> acc;
+        aligned_vector<vec2d> vel;
+        aligned_vector<vec2d> pos;
+        aligned_vector<vec2d> new_acc;
+        aligned_vector<vec2d> new_vel;
+        aligned_vector<vec2d> new_pos;
+        aligned_vector<double> mass;
+        // physical size for collisions
+        aligned_vector<double> radius;
+        aligned_vector<std::uint32_t> class_id;
+
+        // Scratch space for controllers that need more than the current state across the stages of a step. The
+        // columns stay empty until such a controller is first used, so that other scenes don't pay for them.
+        aligned_vector<vec2d> base_pos;
+        aligned_vector<vec2d> base_vel;
+        aligned_vector<vec2d> delta_pos;
+        aligned_vector<vec2d> delta_vel;
+
+        std::size_t push(double m, std::uint32_t clazz);
+        void reserve(std::size_t n);
+        // gives every object, and every one pushed from now on, a row in the scratch columns
+        void enable_scratch();
+
+        // publishes the state computed during the update phase
+        void commit();
+
+        constexpr std::size_t size() const { return mass.size(); }
+
+    private:
+        bool scratch = false;
+    };
+} // namespace phy
+
+#endif
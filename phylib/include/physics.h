@@ -2,17 +2,28 @@
 #define __PHY_PHYSICS_H__
 #include "tracker.h"
 #include <SFML/Graphics.hpp>
+#include <algorithm>
 #include <chrono>
+#include <collider.h>
 #include <logger_ref.h>
 #include <memory>
+#include <optional>
 #include <object.h>
+#include <object_store.h>
 #include <special_object.h>
 #include <stdexcept>
 #include <string>
 #include <util/builers.h>
+#include <util/cell_grid.h>
+#include <util/aligned.h>
 #include <util/chrono_util.h>
+#include <util/diagnostics.h>
+#include <util/field_kernel.h>
 #include <util/obj_class_util.h>
 #include <util/perf_counter.h>
+#include <util/profiler.h>
+#include <util/quadtree.h>
+#include <util/thread_pool.h>
 
 namespace phy
 {
@@ -20,15 +31,24 @@ namespace phy
     {
         friend class object_class_builder;
 
-        sf::RenderWindow& rw;
-        sf::Font& font;
+        // both null for headless spaces
+        sf::RenderWindow* rw;
+        sf::Font* font;
 
         std::unordered_map<std::string, std::unique_ptr<object_class>> clazz;
+        std::vector<object_class*> class_table;
+        std::unique_ptr<object_store> store;
         std::vector<std::unique_ptr<object>> objects;
+        // the objects of every class by class id, in the order they were created
+        std::vector<std::vector<std::size_t>> class_objects;
         std::vector<vec2d> forces_cache;
         std::vector<std::unique_ptr<special_object>> special_objects;
+        spring_network* network = nullptr;
 
         tick_counter<std::chrono::microseconds> tick;
+        // set in fixed step mode, otherwise every cycle steps by the wall clock time it took
+        std::optional<step_accumulator> fixed_clock;
+        bool behind = false;
         framerate_counter counter;
 
         logging::logger_ref ref;
@@ -36,6 +56,104 @@ namespace phy
         std::size_t cycles;
 
         std::unique_ptr<tracker> t;
+        std::unique_ptr<thread_pool> pool;
+
+        // classes whose forces are all field forces are evaluated straight from the store, optionally through a
+        // Barnes-Hut tree per class
+        struct field_group
+        {
+            // the interaction group and the stages of the controller of the class the members belong to
+            std::uint64_t source_group;
+            std::size_t stages;
+            std::vector<std::size_t> members;
+            std::vector<const forces::field_force*> laws;
+            const forces::field_pipeline* pipeline;
+            quadtree tree;
+
+            // forces between members of an antisymmetric group, indexed like `members`; only worth it while most
+            // members are targets and the class feels itself
+            bool symmetric = true;
+            std::size_t targets = 0;
+            std::vector<vec2d> acc;
+
+            // groups made only of integer power laws are summed by the vectorized kernel from packed, padded columns
+            bool vectorized = true;
+            std::vector<kernel::law> kernel_laws;
+            aligned_vector<double> src_x;
+            aligned_vector<double> src_y;
+            aligned_vector<double> src_mass;
+
+            // groups whose laws all have a cutoff only look at the members in the cells around a target
+            double cutoff = 0;
+            cell_grid grid;
+
+            // with a neighbor skin, the members within cutoff + skin of every object, kept until some object has
+            // moved more than half the skin away from where it was when they were built
+            std::vector<std::size_t> neighbor_start;
+            std::vector<std::size_t> neighbors;
+            std::vector<vec2d> neighbor_origin;
+        };
+
+        // objects of colliding classes, those without a radius never touch anything
+        collider collisions;
+
+        // the targets of one class, targets[begin, end)
+        struct target_block
+        {
+            const object_class* clazz;
+            std::size_t begin;
+            std::size_t end;
+        };
+
+        // objects whose controller consumes forces, in blocks by class and ascending within a block; forces are
+        // only summed onto these, the rest only act as sources
+        std::vector<std::size_t> targets;
+        std::vector<target_block> target_blocks;
+        std::vector<std::size_t> direct_sources;
+        std::vector<field_group> field_groups;
+        std::vector<std::size_t> group_of;
+        std::vector<std::size_t> group_slot;
+        bool any_vectorized = false;
+        aligned_vector<double> target_x;
+        aligned_vector<double> target_y;
+        aligned_vector<double> field_x;
+        aligned_vector<double> field_y;
+        double opening_angle = 0;
+        double neighbor_skin = 0;
+        bool groups_dirty = true;
+
+        // force evaluations per step, the most any controller asks for
+        std::size_t stages = 1;
+        std::size_t current_stage = 0;
+        // objects before this one have taken a step
+        std::size_t stepped = 0;
+        // length of the last step, whose kicks synchronize() settles
+        double last_dt = 0;
+
+        // objects with renderers that sample history, sampled every `history_interval` of simulated time or once
+        // per frame if it is 0
+        std::vector<std::size_t> history_objects;
+        double history_interval = 0;
+        double history_time = 0;
+        // simulated time since the space was created
+        double time = 0;
+
+        profiler prof;
+
+        diagnostics::reporter diag;
+        std::chrono::steady_clock::time_point diag_time = std::chrono::steady_clock::now();
+
+        void advance();
+        void draw(const std::string& msg);
+        void rebuild_groups();
+        void compute_forces();
+        void symmetric_forces(field_group& group);
+        bool neighbors_stale(const field_group& group) const;
+        void collide();
+        // sums the forces on targets[begin, end), which all belong to `clazz`
+        void sum_block(const object_class& clazz, std::size_t begin, std::size_t end, bool vectorized);
+        void build_neighbors(field_group& group);
+        void pack_vectorized();
 
     public:
         constexpr double get_tick_mult() const { return subtick_mult; }
@@ -47,6 +165,28 @@ namespace phy
             subtick_mult = m;
         }
 
+        constexpr double get_opening_angle() const { return opening_angle; }
+
+        // enables the Barnes-Hut approximation for classes with only field forces, theta = 0 disables it
+        constexpr void set_opening_angle(double theta)
+        {
+            if (theta < 0)
+                theta = 0;
+            opening_angle = theta;
+            groups_dirty = true;
+        }
+
+        constexpr double get_neighbor_skin() const { return neighbor_skin; }
+
+        // Keeps per-object neighbor lists for classes whose forces have a cutoff, built with cutoff + skin and reused
+        // across steps until the displacement since they were built could let a pair slip inside the cutoff; 0 searches
+        // the cell grid every step instead.
+        constexpr void set_neighbor_skin(double skin)
+        {
+            neighbor_skin = skin > 0 ? skin : 0;
+            groups_dirty = true;
+        }
+
         constexpr void set_cycles(std::size_t n)
         {
             if (n == 0)
@@ -57,14 +197,68 @@ namespace phy
             cycles = n;
         }
 
+        // a space without a window, which can only be advanced through step()
+        inline physics_space(double subtick_mult, std::size_t cycles)
+            : rw(nullptr), font(nullptr), store(std::make_unique<object_store>()), tick(), ref("phy_space"),
+              subtick_mult(subtick_mult), cycles(cycles), pool(std::make_unique<thread_pool>(1))
+        {
+        }
+
         inline physics_space(sf::RenderWindow& rw, sf::Font& font, double subtick_mult, std::size_t cycles)
-            : rw(rw), font(font), tick(), ref("phy_space"), subtick_mult(subtick_mult), cycles(cycles)
+            : physics_space(subtick_mult, cycles)
+        {
+            this->rw = &rw;
+            this->font = &font;
+        }
+
+        constexpr double get_time() const { return time; }
+        constexpr double get_history_interval() const { return history_interval; }
+        constexpr void set_history_interval(double t) { history_interval = t > 0 ? t : 0; }
+
+        // 0 in wall clock mode
+        constexpr double get_fixed_step() const { return fixed_clock ? fixed_clock->get_step() : 0; }
+        constexpr double get_dropped_time() const { return fixed_clock ? fixed_clock->get_dropped() : 0; }
+
+        // Advances the simulation in fixed steps of `step` from render(), as many as the scaled wall clock time
+        // since the last frame pays for but at most `max_steps` per frame; time beyond that is dropped. A step of 0
+        // switches back to one wall clock step per cycle.
+        inline void set_fixed_step(double step, std::size_t max_steps)
+        {
+            if (step > 0)
+                fixed_clock.emplace(step, std::max<std::size_t>(max_steps, 1));
+            else
+                fixed_clock.reset();
+        }
+
+        inline std::size_t get_threads() const { return pool->size(); }
+
+        // most threads a front end should ask set_threads for, far beyond any machine this runs on
+        static constexpr std::size_t MAX_THREADS = 1024;
+
+        // number of threads (including the caller) that force accumulation and integration are split over;
+        // 0 picks one per hardware thread
+        inline void set_threads(std::size_t n)
         {
+            if (n == 0)
+                n = std::max(std::thread::hardware_concurrency(), 1u);
+            if (n != pool->size())
+                pool = std::make_unique<thread_pool>(n);
         }
 
         inline void reset() { tick.dt(); }
 
+        // runs `cycles` steps over the wall clock time since the last call and draws the result
         void render(const std::string& str = "");
+        // advances the simulation by dt without drawing anything
+        void step(double dt);
+        // Controllers that share the closing kick of a step with the next one leave velocities that used the
+        // acceleration the step started with. This settles them with one extra force evaluation, for callers that
+        // need the velocities at the current positions.
+        void synchronize();
+
+        // Logs one line with the diagnostics counted since the last report, if there were any. render() reports
+        // once a second. The counters are shared by every space in the process.
+        void report_diagnostics();
 
         template <typename T>
         object_class_builder& create_class(const std::string& name)
@@ -78,12 +272,38 @@ namespace phy
             return (T*)special_objects.emplace_back(std::make_unique<T>(std::forward<Args>(args)...)).get();
         }
 
+        // the springs of the space, all evaluated together; made the first time it is asked for
+        inline spring_network& springs()
+        {
+            if (!network)
+                network = create_special<spring_network>();
+            return *network;
+        }
+
         inline bool class_exists(const std::string& name) { return clazz.contains(name); }
 
         object_builder create_object(const std::string& name, double mass, const named_value_map& m);
+        // makes room for n more objects of a class, so that creating them in bulk allocates once
+        void reserve(const std::string& clazz_name, std::size_t n);
 
-        constexpr sf::RenderWindow& with_window() { return rw; }
-        constexpr const sf::RenderWindow& with_window() const { return rw; }
+        inline const object_store& get_store() const { return *store; }
+        // whether the controller of an object moves it by the forces it is handed
+        inline bool integrates(std::size_t id) const
+        {
+            return class_table[store->class_id[id]]->get_controller().consumes_forces();
+        }
+        // whether an object takes the stage of the step whose forces are being evaluated, objects whose controller has
+        // fewer stages need no forces after their last one
+        inline bool in_stage(std::size_t id) const
+        {
+            const auto& c = class_table[store->class_id[id]]->get_controller();
+            return c.consumes_forces() && current_stage < c.stages();
+        }
+        constexpr profiler& get_profiler() { return prof; }
+        inline thread_pool& get_pool() { return *pool; }
+        constexpr bool headless() const { return !rw; }
+        constexpr sf::RenderWindow& with_window() { return *rw; }
+        constexpr const sf::RenderWindow& with_window() const { return *rw; }
         inline tracker* make_tracker(double a, std::size_t b, double c)
         {
             return (t = std::make_unique<tracker>(a, b, c)).get();
@@ -2,8 +2,12 @@
 #define __PHYLIB_SPECIAL_OBJECT_H__
 
 #include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/VertexArray.hpp>
+#include <algorithm>
 #include <boost/circular_buffer.hpp>
+#include <cstdint>
 #include <object.h>
+#include <util/thread_pool.h>
 #include <util/vec.h>
 #include <vector>
 namespace phy
@@ -20,21 +24,98 @@ namespace phy
         virtual ~special_object() = default;
     };
 
-    class spring : public special_object
+    // Any number of springs kept in flat arrays and evaluated together. Every step computes the force of each spring
+    // in one pass over the arrays, then gathers them per object through an index of the springs at each object, so
+    // that no two threads ever add to the same force. All springs are drawn as one vertex array.
+    //
+    // Implicit springs take a linearized backward Euler step instead: the velocity change dv of the objects is solved
+    // from (M + dt^2 J) dv = dt (f - dt J v), with f all forces on them and J the derivative of the spring forces
+    // against positions, by conjugate gradients preconditioned with the 2x2 blocks of the diagonal. The objects are
+    // then handed M dv / dt as their whole force, which is exactly that step for an euler_controller. Other
+    // controllers stay stable for stiffer springs than without, but gain less. Forces added by special objects after
+    // the network are still explicit.
+    class spring_network : public special_object
     {
-        const object& o1;
-        const object& o2;
-        double spring_const;
-        double relaxed_len;
-        sf::Color color;
+        // symmetric 2x2 matrix
+        struct sym2
+        {
+            double xx;
+            double xy;
+            double yy;
+
+            constexpr vec2d operator*(const vec2d& v) const
+            {
+                return {xx * v[0] + xy * v[1], xy * v[0] + yy * v[1]};
+            }
+        };
+
+        const object_store* store = nullptr;
+        std::vector<std::size_t> first;
+        std::vector<std::size_t> second;
+        std::vector<double> stiffness;
+        std::vector<double> rest;
+        // force of every spring on its first object, the second one feels the opposite
+        std::vector<vec2d> force;
+
+        // the springs at nodes[n] are incident[node_start[n], node_start[n + 1]), each as 2 * spring + 1 if the node is
+        // its second object and 2 * spring if it is its first
+        std::vector<std::size_t> nodes;
+        std::vector<std::uint32_t> node_start;
+        std::vector<std::uint32_t> incident;
+        // the node at the other end of the spring of every entry of incident
+        std::vector<std::uint32_t> other;
+        bool index_dirty = false;
+
+        bool implicit = false;
+        double tolerance = 1e-3;
+        std::size_t max_iterations = 200;
+        std::size_t iterations = 0;
+
+        // implicit step: the force derivative of every spring
+        std::vector<sym2> jacobian;
+        // per node: mass, 0 for objects the springs do not move, the inverse of the diagonal block, the solution
+        // dv (kept as the first guess of the next step) and the vectors of the iteration
+        std::vector<double> node_mass;
+        std::vector<sym2> inv_diag;
+        std::vector<vec2d> dv;
+        std::vector<vec2d> residual;
+        std::vector<vec2d> precond;
+        std::vector<vec2d> dir;
+        std::vector<vec2d> dir_image;
+
+        sf::VertexArray lines{sf::Lines};
+
+        void build_index();
+        void explicit_forces(physics_space& space, std::vector<vec2d>& vec);
+        void implicit_forces(physics_space& space, std::vector<vec2d>& vec, double dt);
+        // dir_image = (M + dt^2 J) dir over the nodes, returns dir . dir_image
+        double apply(thread_pool& pool, double dt);
+        // conjugate gradients for dv from the right hand side in `residual`, whose squared norm is `rhs`, until the
+        // squared residual is below tolerance^2 * scale
+        void solve(thread_pool& pool, double dt, double rhs, double scale);
 
     public:
-        spring(const object& o1, const object& o2, sf::Color color, double spring_const, double relaxed_len);
+        void add(const object& o1, const object& o2, sf::Color color, double spring_const, double relaxed_len);
+        inline std::size_t size() const { return first.size(); }
+
+        // switches between explicit and backward Euler springs; the solve stops after `max_iterations`, or once the
+        // residual is below `tolerance` relative to the right hand side or, near rest where that vanishes, to the
+        // momentum the other forces add in a step
+        inline void set_implicit(bool on, double tol = 1e-3, std::size_t max_iter = 200)
+        {
+            implicit = on;
+            tolerance = tol;
+            max_iterations = std::max<std::size_t>(max_iter, 1);
+        }
+        constexpr bool is_implicit() const { return implicit; }
+        // conjugate gradient iterations of the last implicit solve
+        constexpr std::size_t last_iterations() const { return iterations; }
+
         virtual void handle_forces(physics_space& space, std::vector<vec2d>& vec, double dt) override;
-        virtual void handle_update(physics_space& space, double dt) override;
-        virtual void handle_step_time() override;
+        virtual void handle_update(physics_space&, double) override {}
+        virtual void handle_step_time() override {}
         virtual void handle_render(sf::RenderTarget&) override;
-        virtual ~spring() = default;
+        virtual ~spring_network() = default;
     };
 } // namespace phy
 
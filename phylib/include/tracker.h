@@ -27,7 +27,7 @@ namespace phy
 
     struct tracked_object
     {
-        object& obj;
+        std::size_t id;
         statspec_types type;
         sf::Color c;
     };
@@ -38,7 +38,7 @@ namespace phy
         std::vector<tracked_object> objects;
         std::vector<boost::circular_buffer<double>> buf;
         std::size_t sample_n;
-        double ticks;
+        double ticks = 0;
         const double sample_ticks;
         double width;
 
@@ -50,7 +50,7 @@ namespace phy
         inline void track(object& obj, statspec_types t, sf::Color c)
         {
             buf.push_back(boost::circular_buffer<double>(sample_n));
-            objects.push_back({obj, t, c});
+            objects.push_back({obj.identifier(), t, c});
         }
 
         ~tracker() = default;
@@ -0,0 +1,41 @@
+#ifndef __PHY_UTIL_ALIGNED_H__
+#define __PHY_UTIL_ALIGNED_H__
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace phy
+{
+    template <typename T, std::size_t A = 64>
+    struct aligned_allocator
+    {
+        using value_type = T;
+
+        template <typename U>
+        struct rebind
+        {
+            using other = aligned_allocator<U, A>;
+        };
+
+        constexpr aligned_allocator() = default;
+        template <typename U>
+        constexpr aligned_allocator(const aligned_allocator<U, A>&)
+        {
+        }
+
+        T* allocate(std::size_t n) { return (T*)::operator new(n * sizeof(T), std::align_val_t(A)); }
+        void deallocate(T* p, std::size_t) { ::operator delete(p, std::align_val_t(A)); }
+
+        template <typename U>
+        constexpr bool operator==(const aligned_allocator<U, A>&) const
+        {
+            return true;
+        }
+    };
+
+    // cache line aligned vector, so that columns can be streamed (and loaded by SIMD code) without straddling lines
+    template <typename T>
+    using aligned_vector = std::vector<T, aligned_allocator<T>>;
+} // namespace phy
+
+#endif
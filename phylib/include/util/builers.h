@@ -1,12 +1,15 @@
 #ifndef __PHY_BUILDER_H__
 #define __PHY_BUILDER_H__
+#include <algorithm>
 #include <component/force.h>
 #include <component/movement.h>
 #include <component/renderer.h>
 #include <component/renderers/arrow_renderer.h>
 #include <component/renderers/circle_renderer.h>
 #include <component/renderers/trail_renderer.h>
+#include <concepts>
 #include <memory>
+#include <stdexcept>
 #include <object.h>
 #include <string>
 #include <unordered_map>
@@ -41,6 +44,12 @@ namespace phy
             return *this;
         }
 
+        constexpr object_builder& radius(double r)
+        {
+            obj.set_radius(r);
+            return *this;
+        }
+
         constexpr object_builder& vel(double x, double y) { return vel({x, y}); }
         constexpr object_builder& pos(double x, double y) { return pos({x, y}); }
         constexpr object_builder& momentum(double x, double y) { return momentum({x, y}); }
@@ -58,29 +67,76 @@ namespace phy
         }
 
         std::vector<std::unique_ptr<forces::force>> forces;
+        std::vector<std::unique_ptr<forces::body_force>> body_forces;
         std::vector<std::unique_ptr<render::renderer>> renderers;
-        std::vector<void (*)(void*)> deleters;
+        std::vector<column_factory> columns;
 
         std::unique_ptr<movement::movement_controller> controller;
+        double restitution = -1;
+        std::uint64_t group_bit = 1;
+        std::uint64_t feel_mask = ~std::uint64_t(0);
 
         std::unordered_map<std::string, std::size_t> name2idx;
         std::size_t idx = 0;
         std::string name;
 
-        std::size_t register_type(const char* name, void (*del)(void*));
+        std::size_t register_type(const char* name, column_factory make);
+
+        static constexpr std::uint64_t group_mask(std::size_t g)
+        {
+            if (g >= MAX_GROUPS)
+                throw std::out_of_range("interaction groups are 0 to " + std::to_string(MAX_GROUPS - 1) + ", got " +
+                                        std::to_string(g));
+            return std::uint64_t(1) << g;
+        }
 
     public:
         template <typename F, typename... Args>
         constexpr object_class_builder& force(Args&&... args)
         {
-            forces.push_back(std::make_unique<F>(std::forward<Args>(args)...));
+            if constexpr (std::derived_from<F, forces::body_force>)
+                body_forces.push_back(std::make_unique<F>(std::forward<Args>(args)...));
+            else
+                forces.push_back(std::make_unique<F>(std::forward<Args>(args)...));
             return *this;
         }
 
         constexpr object_class_builder& gravity(double constant) { return force<forces::gravity>(constant); }
+        constexpr object_class_builder& softgravity(double constant, double eps)
+        {
+            return force<forces::softened_gravity>(constant, eps);
+        }
+        constexpr object_class_builder& field(double constant, double power, double cutoff = 0)
+        {
+            return force<forces::simple_field>(constant, power, cutoff);
+        }
         constexpr object_class_builder& const_acc(const vec2d& v) { return force<forces::const_acc>(v); }
         constexpr object_class_builder& const_acc(double x, double y) { return force<forces::const_acc>(vec2d{x, y}); }
 
+        // objects of this class collide with those of every other colliding class, `restitution` is 1 for elastic
+        // and 0 for perfectly inelastic collisions
+        constexpr object_class_builder& collide(double e)
+        {
+            restitution = std::clamp(e, 0.0, 1.0);
+            return *this;
+        }
+
+        // Every class is in interaction group 0 unless moved to another one of the MAX_GROUPS groups here, and feels
+        // the forces of every group it does not ignore. A class that ignores its own group has no forces between its
+        // objects. Groups from MAX_GROUPS on throw std::out_of_range.
+        static constexpr std::size_t MAX_GROUPS = 64;
+        constexpr object_class_builder& group(std::size_t g)
+        {
+            group_bit = group_mask(g);
+            return *this;
+        }
+
+        constexpr object_class_builder& ignores(std::size_t g)
+        {
+            feel_mask &= ~group_mask(g);
+            return *this;
+        }
+
         template <typename F, typename... Args>
         constexpr object_class_builder& renderer(Args&&... args)
         {
@@ -91,6 +147,10 @@ namespace phy
 
         inline object_class_builder& circle() { return renderer<render::circle_renderer>(); }
         inline object_class_builder& trail(double min_dist) { return renderer<render::trail_renderer>(min_dist); }
+        inline object_class_builder& trail(double min_dist, std::size_t max_points, double max_age)
+        {
+            return renderer<render::trail_renderer>(min_dist, max_points, max_age);
+        }
 
         inline object_class_builder& render_vel(double scale)
         {
@@ -102,6 +162,8 @@ namespace phy
             return renderer<render::arrow_renderer<render::ACC>>(scale);
         }
 
+        // registers the class with the space and frees the builder, throws std::invalid_argument if the space already
+        // has a class of that name
         void build();
     };
 } // namespace phy
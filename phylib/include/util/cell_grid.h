@@ -0,0 +1,82 @@
+#ifndef __PHY_UTIL_CELL_GRID_H__
+#define __PHY_UTIL_CELL_GRID_H__
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <util/vec.h>
+#include <vector>
+
+namespace phy
+{
+    // Unbounded uniform grid over a set of points, for forces with a cutoff. Cells are as wide as the cutoff, so
+    // everything within the cutoff of a point lies in the 3x3 block of cells around it. Cells are hashed into about
+    // twice as many buckets as there are points, so memory does not depend on how far the points are spread; a
+    // bucket may hold points of unrelated cells, which the cutoff then rejects.
+    class cell_grid
+    {
+        struct point
+        {
+            vec2d pos;
+            std::size_t id;
+        };
+
+        std::vector<point> points;
+        std::vector<std::size_t> ids;
+        // ids[start[b], start[b + 1]) are the points hashed into bucket b
+        std::vector<std::uint32_t> start;
+        std::vector<std::uint32_t> bucket_of;
+        std::vector<std::uint32_t> cursor;
+        double inv_cell = 1;
+        std::size_t mask = 0;
+
+        inline std::int64_t coord(double x) const
+        {
+            constexpr double LIMIT = 1e15;
+            double c = std::floor(x * inv_cell);
+            if (!(std::abs(c) < LIMIT))
+                c = c > 0 ? LIMIT : -LIMIT;
+            return (std::int64_t)c;
+        }
+
+        inline std::size_t bucket(std::int64_t x, std::int64_t y) const
+        {
+            std::uint64_t h = (std::uint64_t)x * 0x9e3779b97f4a7c15ull ^ (std::uint64_t)y * 0xc2b2ae3d27d4eb4full;
+            return (h ^ h >> 29) & mask;
+        }
+
+    public:
+        inline void clear() { points.clear(); }
+        inline void insert(std::size_t id, const vec2d& pos) { points.push_back({pos, id}); }
+        void build(double cutoff);
+
+        constexpr std::size_t size() const { return points.size(); }
+
+        // Calls on_range(ids, n) once for every bucket holding the cells around `p`. The ranges may include points
+        // beyond the cutoff, but never the same point twice.
+        template <typename F>
+        void near(const vec2d& p, F&& on_range) const
+        {
+            if (points.empty())
+                return;
+
+            std::size_t found[9];
+            std::size_t n = 0;
+            std::int64_t cx = coord(p[0]);
+            std::int64_t cy = coord(p[1]);
+            for (std::int64_t y = cy - 1; y <= cy + 1; y++)
+            {
+                for (std::int64_t x = cx - 1; x <= cx + 1; x++)
+                {
+                    std::size_t b = bucket(x, y);
+                    if (start[b] != start[b + 1] && std::find(found, found + n, b) == found + n)
+                        found[n++] = b;
+                }
+            }
+
+            for (std::size_t i = 0; i < n; i++)
+                on_range(ids.data() + start[found[i]], start[found[i] + 1] - start[found[i]]);
+        }
+    };
+} // namespace phy
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef __PHY_INCLUDE_UTIL_CHRONO_UTIL_H__
 #define __PHY_INCLUDE_UTIL_CHRONO_UTIL_H__
 #include <chrono>
+#include <cstddef>
 
 namespace phy
 {
@@ -20,6 +21,40 @@ namespace phy
             return dt;
         }
     };
+
+    // Turns elapsed time into a whole number of fixed steps. Time that does not add up to a full step carries over to
+    // the next call, time beyond `max_steps` steps is dropped so that a stall does not turn into a burst of steps.
+    class step_accumulator
+    {
+        double step;
+        std::size_t max_steps;
+        double pending = 0;
+        double dropped = 0;
+
+    public:
+        constexpr step_accumulator(double step, std::size_t max_steps) : step(step), max_steps(max_steps) {}
+
+        // adds `elapsed` time and returns the number of steps it pays for
+        constexpr std::size_t advance(double elapsed)
+        {
+            pending += elapsed;
+            std::size_t n = pending / step;
+            if (n > max_steps)
+            {
+                dropped += pending - max_steps * step;
+                pending = 0;
+                return max_steps;
+            }
+
+            pending -= n * step;
+            return n;
+        }
+
+        constexpr double get_step() const { return step; }
+        constexpr std::size_t get_max_steps() const { return max_steps; }
+        // total time dropped so far
+        constexpr double get_dropped() const { return dropped; }
+    };
 } // namespace phy
 
 #endif
@@ -0,0 +1,62 @@
+#ifndef __PHY_UTIL_DIAGNOSTICS_H__
+#define __PHY_UTIL_DIAGNOSTICS_H__
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace phy::diagnostics
+{
+    // Conditions the force and integration loops run into. They are counted instead of logged, so that hitting one
+    // for every pair of a dense scene costs an increment rather than a formatted log line.
+    enum counter : std::size_t
+    {
+        CLOSE_ENCOUNTER,  // a force clamped the distance between two bodies
+        HUGE_DELTA_V,     // a step changed a velocity by more than 750
+        VELOCITY_CLAMPED, // a velocity was limited to 1e6
+        NON_FINITE,       // an update produced a NaN or infinite position or velocity
+        COUNTER_COUNT,
+    };
+
+    using totals = std::array<std::uint64_t, COUNTER_COUNT>;
+
+    // The counters of one thread. Only the owning thread writes to them, so an increment is a relaxed load and store
+    // that never contends with anything.
+    struct slots
+    {
+        std::array<std::atomic<std::uint64_t>, COUNTER_COUNT> values{};
+        std::atomic<bool> in_use{true};
+    };
+
+    namespace detail
+    {
+        inline thread_local slots* local = nullptr;
+        // registers the slots of the calling thread, reusing the slots of a thread that has exited
+        slots* attach();
+    } // namespace detail
+
+    inline void count(counter c, std::uint64_t n = 1)
+    {
+        slots* s = detail::local ? detail::local : detail::attach();
+        auto& v = s->values[c];
+        v.store(v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    // counts of every thread since the process started
+    totals collect();
+    const char* name(counter c);
+
+    // hands out the counts since its previous poll, for periodic reports
+    class reporter
+    {
+        totals last{};
+
+    public:
+        totals poll();
+        // "n close encounters, ..." for the non-zero counts, empty if there are none
+        static std::string describe(const totals& t);
+    };
+} // namespace phy::diagnostics
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef __PHY_UTIL_FIELD_KERNEL_H__
+#define __PHY_UTIL_FIELD_KERNEL_H__
+#include <cstddef>
+#include <limits>
+
+namespace phy::kernel
+{
+    // One term of a power law field: constant * min(1 / r, cap)^power, directed towards the source. With softening,
+    // the term is constant * r / (r^2 + soft)^((power + 1) / 2) instead, and cap is ignored.
+    struct law
+    {
+        double constant;
+        int power;
+        double cap = std::numeric_limits<double>::infinity();
+        double soft = 0;
+    };
+
+    enum class isa
+    {
+        SCALAR,
+        AVX2,
+        AVX512,
+    };
+
+    // source arrays passed to field_sum have to be padded to a multiple of this, with zero mass padding
+    inline constexpr std::size_t SOURCE_PAD = 8;
+
+    // best instruction set supported by the running CPU
+    isa detect();
+    isa active();
+    // selects `i`, or the best supported instruction set below it
+    void select(isa i);
+    const char* name(isa i);
+
+    // For every target t in [begin, end), adds sum_j m_j * sum_l(law_l(r)) * (src_j - tgt_t) / r to (ax[t], ay[t]),
+    // where r = |tgt_t - src_j|. Coincident pairs are skipped, which also excludes a target from its own sum.
+    void field_sum(const law* laws, std::size_t nlaws, const double* sx, const double* sy, const double* sm,
+                   std::size_t ns, const double* tx, const double* ty, std::size_t begin, std::size_t end, double* ax,
+                   double* ay);
+} // namespace phy::kernel
+
+#endif
@@ -1,15 +1,46 @@
 #ifndef __PHY_UTIL_OBJ_CLASS_UTIL_H__
 #define __PHY_UTIL_OBJ_CLASS_UTIL_H__
 #include <any>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 namespace phy
 {
-    using value_map = std::vector<void*>;
     using named_value_map = std::unordered_map<std::string, std::any>;
 
+    // The values of one slot for every object of a class, in creation order. Columns of different types sit side by
+    // side in a class, so growing them goes through this interface while reading them does not.
+    class slot_column
+    {
+    public:
+        virtual void resize(std::size_t n) = 0;
+        virtual void reserve(std::size_t n) = 0;
+        virtual ~slot_column() = default;
+    };
+
+    template <typename T>
+    class typed_column : public slot_column
+    {
+    public:
+        std::vector<T> values;
+
+        virtual void resize(std::size_t n) override { values.resize(n); }
+        virtual void reserve(std::size_t n) override { values.reserve(n); }
+    };
+
+    using slot_columns = std::vector<std::unique_ptr<slot_column>>;
+
+    // the slots of one object, its row in the columns of its class
+    struct value_map
+    {
+        slot_columns* columns;
+        std::size_t row;
+    };
+
+    // Slot `v` of a class. Columns grow as objects are created, so a pointer from get() is only good until the next
+    // object of the class is.
     template <typename T>
     class indexed_type
     {
@@ -19,8 +50,11 @@ namespace phy
         constexpr indexed_type(std::size_t index) : v(index) {}
         constexpr indexed_type(const indexed_type&) = default;
         constexpr indexed_type(indexed_type&&) = default;
-        constexpr T* get(const value_map& vmap) const { return (T*)vmap[v]; }
-        constexpr void write(value_map& vmap, T* new_val) const { vmap[v] = new_val; }
+        constexpr T* get(const value_map& vmap) const
+        {
+            return &static_cast<typed_column<T>&>(*(*vmap.columns)[v]).values[vmap.row];
+        }
+        constexpr void write(const value_map& vmap, T&& new_val) const { *get(vmap) = std::move(new_val); }
     };
 
     template <typename T>
@@ -33,6 +67,7 @@ namespace phy
         constexpr named_type(const named_type&) = default;
         constexpr named_type(named_type&&) = default;
         constexpr T* get(const named_value_map& vmap) const { return (T*)vmap.at(v); }
+        constexpr const char* name() const { return v; }
 
         template <typename... Args>
         std::pair<std::string, std::any> operator()(Args&&... args) const
@@ -59,19 +94,15 @@ namespace phy
     };
 
     class object_class_builder;
-    using slot_allocator = bound_pmf<object_class_builder, std::size_t, const char*, void (*)(void*)>;
+    using column_factory = std::unique_ptr<slot_column> (*)();
+    using slot_allocator = bound_pmf<object_class_builder, std::size_t, const char*, column_factory>;
 
-    template <typename T, bool B = false>
+    template <typename T>
     indexed_type<T> alloc_slot(const slot_allocator& alloc, const char* str = nullptr)
     {
         const char* str2 = str;
         return indexed_type<T>(alloc.invoke(
-            str2, +[](void* p) {
-                if constexpr (B)
-                    delete[]((T*)p);
-                else
-                    delete ((T*)p);
-            }));
+            str2, +[]() -> std::unique_ptr<slot_column> { return std::make_unique<typed_column<T>>(); }));
     }
 
     using index_map = std::unordered_map<std::string, std::size_t>;
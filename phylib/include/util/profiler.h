@@ -0,0 +1,116 @@
+#ifndef __PHY_UTIL_PROFILER_H__
+#define __PHY_UTIL_PROFILER_H__
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace phy
+{
+    // Wall clock profiler for the phases of a frame. Phases are timed by scopes and nest the way the scopes do; their
+    // time is summed per frame, and once per second the frame totals are reduced to min/mean/p99. Scopes are only
+    // meant to be opened from the thread driving the simulation.
+    class profiler
+    {
+    public:
+        using clock = std::chrono::steady_clock;
+        static constexpr std::uint32_t NONE = -1;
+        static constexpr std::size_t MAX_TRACE_EVENTS = 1 << 20;
+
+        // milliseconds per frame
+        struct stats
+        {
+            double min = 0;
+            double mean = 0;
+            double p99 = 0;
+            double calls = 0;
+        };
+
+        struct phase
+        {
+            const char* name;
+            std::uint32_t parent;
+            std::uint32_t depth;
+            double frame_time = 0;
+            std::size_t frame_calls = 0;
+            std::size_t calls = 0;
+            std::vector<double> samples;
+            stats last;
+        };
+
+        class scope
+        {
+            profiler* p;
+            clock::time_point start;
+
+            friend class profiler;
+            inline scope(profiler* p) : p(p)
+            {
+                if (p)
+                    start = clock::now();
+            }
+
+        public:
+            scope(const scope&) = delete;
+            inline ~scope()
+            {
+                if (p)
+                    p->leave(start);
+            }
+        };
+
+    private:
+        struct event
+        {
+            std::uint32_t phase;
+            std::int64_t start;
+            std::int64_t duration;
+        };
+
+        bool enabled = false;
+        bool tracing = false;
+        std::vector<phase> phases;
+        std::vector<std::uint32_t> stack;
+        std::vector<event> events;
+        clock::time_point epoch = clock::now();
+        clock::time_point window_start = clock::now();
+        std::size_t frames = 0;
+        std::string summary;
+
+        std::uint32_t child(std::uint32_t parent, const char* name);
+        void leave(clock::time_point start);
+
+    public:
+        constexpr bool is_enabled() const { return enabled; }
+        constexpr bool is_tracing() const { return tracing; }
+        inline void set_enabled(bool e) { enabled = e; }
+        // also records every scope as a trace event, up to MAX_TRACE_EVENTS
+        inline void set_tracing(bool t)
+        {
+            tracing = t;
+            enabled = enabled || t;
+        }
+
+        // times the enclosing block as phase `name` below the innermost open phase; phases are told apart by the
+        // address of their name, so it should be a string literal
+        inline scope time(const char* name)
+        {
+            if (!enabled)
+                return scope(nullptr);
+            stack.push_back(child(stack.empty() ? NONE : stack.back(), name));
+            return scope(this);
+        }
+
+        void end_frame();
+        // reduces the frames since the last reduction right away
+        void flush();
+
+        constexpr const std::vector<phase>& get_phases() const { return phases; }
+        // one line per phase, indented by depth, as of the last reduction
+        constexpr const std::string& get_summary() const { return summary; }
+        // writes the recorded events in the Chrome trace event format
+        bool write_trace(const std::string& file) const;
+    };
+} // namespace phy
+
+#endif
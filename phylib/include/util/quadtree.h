@@ -0,0 +1,98 @@
+#ifndef __PHY_UTIL_QUADTREE_H__
+#define __PHY_UTIL_QUADTREE_H__
+#include <cmath>
+#include <cstdint>
+#include <util/vec.h>
+#include <vector>
+
+namespace phy
+{
+    // Barnes-Hut quadtree over a set of point masses. Every cell keeps the total mass and center of mass of the bodies
+    // below it, so that a cell that is far enough away from a target can stand in for all of its bodies.
+    class quadtree
+    {
+    public:
+        struct body
+        {
+            vec2d pos;
+            double mass;
+            std::size_t id;
+        };
+
+        struct node
+        {
+            vec2d center;
+            double half;
+            vec2d com;
+            double mass;
+            std::uint32_t child; // first of four consecutive children, 0 for leaves
+            std::uint32_t begin;
+            std::uint32_t end;
+        };
+
+        static constexpr std::size_t LEAF_SIZE = 8;
+        static constexpr std::size_t MAX_DEPTH = 48;
+
+    private:
+        std::vector<node> nodes;
+        std::vector<body> bodies;
+
+        void subdivide(std::uint32_t n, std::size_t depth);
+
+    public:
+        inline void clear()
+        {
+            nodes.clear();
+            bodies.clear();
+        }
+
+        inline void insert(std::size_t id, const vec2d& pos, double mass) { bodies.push_back({pos, mass, id}); }
+        void build();
+
+        constexpr std::size_t size() const { return bodies.size(); }
+        constexpr const std::vector<node>& get_nodes() const { return nodes; }
+
+        // Walks the tree for a target at `p`. Leaves that have to be opened are reported body by body through
+        // `on_body(id, pos, mass)`; cells that satisfy the opening criterion size / dist < theta are reported through
+        // `on_cell(com, mass)`. Cells containing the target are always opened.
+        template <typename B, typename C>
+        void walk(const vec2d& p, double theta, B&& on_body, C&& on_cell) const
+        {
+            if (nodes.empty())
+                return;
+
+            std::uint32_t stack[3 * MAX_DEPTH + 4];
+            std::size_t top = 0;
+            double theta_sq = theta * theta;
+            stack[top++] = 0;
+
+            while (top)
+            {
+                const node& n = nodes[stack[--top]];
+                if (n.begin == n.end)
+                    continue;
+
+                if (n.child == 0)
+                {
+                    for (std::uint32_t i = n.begin; i < n.end; i++)
+                        on_body(bodies[i].id, bodies[i].pos, bodies[i].mass);
+                    continue;
+                }
+
+                vec2d d = n.com - p;
+                double size = 2 * n.half;
+                bool inside = std::abs(p[0] - n.center[0]) <= n.half && std::abs(p[1] - n.center[1]) <= n.half;
+                if (!inside && size * size < theta_sq * d.dot(d))
+                {
+                    on_cell(n.com, n.mass);
+                    continue;
+                }
+
+                for (std::uint32_t i = 0; i < 4; i++)
+                    stack[top++] = n.child + i;
+            }
+        }
+    };
+} // namespace phy
+
+#endif
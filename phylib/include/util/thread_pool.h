@@ -0,0 +1,51 @@
+#ifndef __PHY_UTIL_THREAD_POOL_H__
+#define __PHY_UTIL_THREAD_POOL_H__
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace phy
+{
+    // A fixed set of worker threads that run data parallel loops. The calling thread takes part in every loop, so a
+    // pool of size 1 has no workers and runs everything inline.
+    class thread_pool
+    {
+    public:
+        using range_fn = std::function<void(std::size_t, std::size_t)>;
+
+    private:
+        std::vector<std::thread> workers;
+        std::mutex lock;
+        std::condition_variable start_cv;
+        std::condition_variable done_cv;
+
+        const range_fn* job = nullptr;
+        std::size_t job_size = 0;
+        std::size_t job_parts = 0;
+        std::size_t generation = 0;
+        std::size_t pending = 0;
+        std::exception_ptr error;
+        bool stop = false;
+
+        void worker(std::size_t index);
+
+    public:
+        explicit thread_pool(std::size_t n);
+        thread_pool(const thread_pool&) = delete;
+        thread_pool& operator=(const thread_pool&) = delete;
+        ~thread_pool();
+
+        inline std::size_t size() const { return workers.size() + 1; }
+
+        // Splits [0, n) into contiguous chunks of at least `grain` elements and runs `fn(begin, end)` on each.
+        // Chunk k is always [n * k / parts, n * (k + 1) / parts) and always runs on thread k, so the partition only
+        // depends on n and the pool size.
+        void parallel_for(std::size_t n, const range_fn& fn, std::size_t grain = 1);
+    };
+} // namespace phy
+
+#endif
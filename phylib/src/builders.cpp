@@ -1,14 +1,15 @@
 #include <memory>
 #include <object_class.h>
 #include <physics.h>
+#include <stdexcept>
 #include <util/builers.h>
 namespace phy
 {
-    std::size_t object_class_builder::register_type(const char* name, void (*del)(void*))
+    std::size_t object_class_builder::register_type(const char* name, column_factory make)
     {
         if (!name)
         {
-            deleters.push_back(del);
+            columns.push_back(make);
             return idx++;
         }
 
@@ -16,23 +17,47 @@ namespace phy
             return name2idx.at(name);
 
         std::size_t ret = idx++;
-        deleters.push_back(del);
+        columns.push_back(make);
         name2idx[name] = ret;
         return ret;
     }
 
     void object_class_builder::build()
     {
+        // builders are handed out by create_class and free themselves once built, or once refused
+        std::unique_ptr<object_class_builder> self(this);
+
+        // the objects of a class refer to it by id, replacing it would leave them with a dangling class
+        if (space.class_exists(name))
+            throw std::invalid_argument("class " + name + " is already defined");
+
         std::unique_ptr<object_class> clazz(new object_class());
         clazz->forces = std::move(forces);
+        clazz->body_forces = std::move(body_forces);
+        clazz->field_kernel = forces::make_field_pipeline(clazz->forces);
+        clazz->body_kernel = forces::make_body_pipeline(clazz->body_forces);
         clazz->renderers = std::move(renderers);
-        clazz->deleters = std::move(deleters);
+        for (const auto& i : clazz->renderers)
+        {
+            if (i->samples_history())
+                clazz->samplers.push_back(i.get());
+            if (i->batched())
+                clazz->batch_renderers.push_back(i.get());
+            else
+                clazz->object_renderers.push_back(i.get());
+        }
+        for (auto make : columns)
+            clazz->slots.push_back(make());
         clazz->named_vmap = std::move(name2idx);
         clazz->controller = std::move(controller);
+        clazz->restitution = restitution;
+        clazz->group = group_bit;
+        clazz->feel_mask = feel_mask;
+        clazz->id = space.class_table.size();
+        if (clazz->controller->uses_scratch())
+            space.store->enable_scratch();
 
+        space.class_table.push_back(clazz.get());
         space.clazz[name] = std::move(clazz);
-
-        // !!!
-        delete this;
     }
 } // namespace phy
@@ -0,0 +1,34 @@
+#include <bit>
+#include <util/cell_grid.h>
+
+namespace phy
+{
+    void cell_grid::build(double cutoff)
+    {
+        ids.clear();
+        start.clear();
+        if (points.empty())
+            return;
+
+        inv_cell = 1 / cutoff;
+        std::size_t buckets = std::bit_ceil(2 * points.size());
+        mask = buckets - 1;
+
+        // counting sort by bucket, stable so that every bucket lists its points in insertion order
+        start.assign(buckets + 1, 0);
+        bucket_of.resize(points.size());
+        for (std::size_t i = 0; i < points.size(); i++)
+        {
+            bucket_of[i] = bucket(coord(points[i].pos[0]), coord(points[i].pos[1]));
+            start[bucket_of[i] + 1]++;
+        }
+
+        for (std::size_t b = 0; b < buckets; b++)
+            start[b + 1] += start[b];
+
+        ids.resize(points.size());
+        cursor.assign(start.begin(), start.end() - 1);
+        for (std::size_t i = 0; i < points.size(); i++)
+            ids[cursor[bucket_of[i]]++] = points[i].id;
+    }
+} // namespace phy
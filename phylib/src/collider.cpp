@@ -0,0 +1,177 @@
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <collider.h>
+
+namespace phy
+{
+    void collider::sort(const object_store& store)
+    {
+        double max_radius = 0;
+        for (auto& b : boxes)
+        {
+            b.pos = store.pos[b.id];
+            b.radius = store.radius[b.id];
+            b.lo = b.pos[0] - b.radius;
+            b.hi = b.pos[0] + b.radius;
+            max_radius = std::max(max_radius, b.radius);
+        }
+
+        auto before = [](const box& l, const box& r) { return l.lo < r.lo || (l.lo == r.lo && l.id < r.id); };
+        if (!sorted)
+        {
+            std::sort(boxes.begin(), boxes.end(), before);
+            sorted = true;
+        }
+        else
+        {
+            for (std::size_t i = 1; i < boxes.size(); i++)
+            {
+                if (!before(boxes[i], boxes[i - 1]))
+                    continue;
+
+                box b = boxes[i];
+                std::size_t j = i;
+                for (; j > 0 && before(b, boxes[j - 1]); j--)
+                    boxes[j] = boxes[j - 1];
+                boxes[j] = b;
+            }
+        }
+
+        // a band at least as high as any body means that none reaches into more than two
+        inv_band = max_radius > 0 ? 1 / (2 * max_radius) : 0;
+    }
+
+    void collider::bin()
+    {
+        entries.clear();
+        start.clear();
+        if (inv_band == 0)
+            return;
+
+        constexpr std::uint32_t NONE = -1;
+        std::size_t buckets = std::bit_ceil(boxes.size());
+        mask = buckets - 1;
+
+        // counting sort by bucket, stable so that every bucket stays sorted by lo
+        start.assign(buckets + 1, 0);
+        low.resize(boxes.size());
+        high.resize(boxes.size());
+        for (std::size_t i = 0; i < boxes.size(); i++)
+        {
+            box& b = boxes[i];
+            b.band = band_of(b.pos[1] - b.radius);
+            std::int64_t top = band_of(b.pos[1] + b.radius);
+            low[i] = bucket(b.band);
+            high[i] = top != b.band && bucket(top) != low[i] ? bucket(top) : NONE;
+
+            start[low[i] + 1]++;
+            if (high[i] != NONE)
+                start[high[i] + 1]++;
+        }
+
+        for (std::size_t k = 0; k < buckets; k++)
+            start[k + 1] += start[k];
+
+        entries.resize(start[buckets]);
+        cursor.assign(start.begin(), start.end() - 1);
+        for (std::size_t i = 0; i < boxes.size(); i++)
+        {
+            entries[cursor[low[i]]++] = i;
+            if (high[i] != NONE)
+                entries[cursor[high[i]]++] = i;
+        }
+    }
+
+    std::size_t collider::sweep(thread_pool& pool)
+    {
+        for (auto& i : contacts)
+            i.clear();
+        if (start.empty())
+            return 0;
+
+        // every bucket is swept on its own, so the parts are independent and concatenate to the same list for any
+        // number of threads
+        std::size_t parts = pool.size();
+        std::size_t buckets = start.size() - 1;
+        contacts.resize(parts);
+        pool.parallel_for(parts, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t p = begin; p < end; p++)
+            {
+                auto& out = contacts[p];
+                for (std::size_t k = buckets * p / parts; k < buckets * (p + 1) / parts; k++)
+                {
+                    const std::uint32_t* first = entries.data() + start[k];
+                    const std::uint32_t* last = entries.data() + start[k + 1];
+                    for (auto a = first; a != last; a++)
+                    {
+                        const box& l = boxes[*a];
+                        for (auto b = a + 1; b != last && boxes[*b].lo <= l.hi; b++)
+                        {
+                            const box& r = boxes[*b];
+                            vec2d d = r.pos - l.pos;
+                            double reach = l.radius + r.radius;
+                            if (!(d.dot(d) < reach * reach))
+                                continue;
+
+                            // a pair that shares two bands, or two bands of one bucket, is only reported once: in
+                            // the bucket of the band their overlap starts in
+                            if (bucket(std::max(l.band, r.band)) == k)
+                                out.push_back({*a, *b});
+                        }
+                    }
+                }
+            }
+        });
+
+        std::size_t ret = 0;
+        for (const auto& i : contacts)
+            ret += i.size();
+        return ret;
+    }
+
+    void collider::respond(object_store& store) const
+    {
+        for (const auto& part : contacts)
+        {
+            for (const auto& c : part)
+            {
+                const box& l = boxes[c.a];
+                const box& r = boxes[c.b];
+                std::size_t i = l.id;
+                std::size_t j = r.id;
+
+                // earlier contacts may have moved either body since the sweep
+                vec2d d = store.pos[j] - store.pos[i];
+                double reach = l.radius + r.radius;
+                double dist_sq = d.dot(d);
+                if (!(dist_sq < reach * reach))
+                    continue;
+
+                double inv_i = l.movable && store.mass[i] > 0 ? 1 / store.mass[i] : 0;
+                double inv_j = r.movable && store.mass[j] > 0 ? 1 / store.mass[j] : 0;
+                double inv = inv_i + inv_j;
+                if (inv == 0)
+                    continue;
+
+                // coincident centers have no direction, separate them along x
+                double dist = std::sqrt(dist_sq);
+                vec2d n = dist > 0 ? d / dist : vec2d{1, 0};
+
+                // move both out of contact in proportion to their inverse mass, so that the center of mass stays
+                vec2d push = n * ((reach - dist) / inv);
+                store.pos[i] = store.new_pos[i] = store.pos[i] - push * inv_i;
+                store.pos[j] = store.new_pos[j] = store.pos[j] + push * inv_j;
+
+                double approach = (store.vel[j] - store.vel[i]).dot(n);
+                if (approach >= 0)
+                    continue;
+
+                double e = std::min(l.restitution, r.restitution);
+                vec2d impulse = n * (-(1 + e) * approach / inv);
+                store.vel[i] = store.new_vel[i] = store.vel[i] - impulse * inv_i;
+                store.vel[j] = store.new_vel[j] = store.vel[j] + impulse * inv_j;
+            }
+        }
+    }
+} // namespace phy
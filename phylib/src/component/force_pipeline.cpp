@@ -0,0 +1,93 @@
+#include <component/force_pipeline.h>
+#include <object.h>
+#include <optional>
+#include <utility>
+
+namespace phy::forces
+{
+    void virtual_body_pipeline::accumulate(const object_store&, const std::unique_ptr<object>* objects,
+                                           const std::size_t* ids, std::size_t n, vec2d* out) const
+    {
+        for (std::size_t k = 0; k < n; k++)
+        {
+            std::size_t i = ids[k];
+            vec2d force;
+            for (auto f : forces)
+                force += f->compute_force(*objects[i]);
+            out[i] += force;
+        }
+    }
+
+    template <typename... F, typename T, std::size_t... I>
+    static std::optional<std::tuple<F...>> match(const std::vector<std::unique_ptr<T>>& forces,
+                                                 std::index_sequence<I...>)
+    {
+        if (forces.size() != sizeof...(F) || !((dynamic_cast<const F*>(forces[I].get()) != nullptr) && ...))
+            return std::nullopt;
+        return std::tuple<F...>{static_cast<const F&>(*forces[I])...};
+    }
+
+    // matches `forces` against the types F..., in order
+    template <typename... F, typename T>
+    static std::optional<std::tuple<F...>> match(const std::vector<std::unique_ptr<T>>& forces)
+    {
+        return match<F...>(forces, std::index_sequence_for<F...>());
+    }
+
+    template <typename... F>
+    static std::unique_ptr<body_pipeline> fuse_body(const std::vector<std::unique_ptr<body_force>>& forces)
+    {
+        auto m = match<F...>(forces);
+        if (!m)
+            return nullptr;
+        return std::apply([](const F&... f) { return std::make_unique<fused_body_pipeline<F...>>(f...); }, *m);
+    }
+
+    template <typename... F>
+    static std::unique_ptr<field_pipeline> fuse_field(const std::vector<std::unique_ptr<force>>& forces)
+    {
+        auto m = match<F...>(forces);
+        if (!m)
+            return nullptr;
+        return std::make_unique<basic_field_pipeline<fused_laws<F...>>>(fused_laws<F...>{*m});
+    }
+
+    std::unique_ptr<body_pipeline> make_body_pipeline(const std::vector<std::unique_ptr<body_force>>& forces)
+    {
+        if (forces.empty())
+            return nullptr;
+
+        std::unique_ptr<body_pipeline> p;
+        if ((p = fuse_body<const_acc>(forces)) || (p = fuse_body<force_drag>(forces)) ||
+            (p = fuse_body<const_acc, force_drag>(forces)) || (p = fuse_body<force_drag, const_acc>(forces)))
+            return p;
+
+        std::vector<body_force*> ptrs;
+        for (const auto& f : forces)
+            ptrs.push_back(f.get());
+        return std::make_unique<virtual_body_pipeline>(std::move(ptrs));
+    }
+
+    std::unique_ptr<field_pipeline> make_field_pipeline(const std::vector<std::unique_ptr<force>>& forces)
+    {
+        if (forces.empty())
+            return nullptr;
+
+        std::unique_ptr<field_pipeline> p;
+        if ((p = fuse_field<gravity>(forces)) || (p = fuse_field<softened_gravity>(forces)) ||
+            (p = fuse_field<simple_field>(forces)) || (p = fuse_field<gravity, simple_field>(forces)) ||
+            (p = fuse_field<simple_field, gravity>(forces)))
+            return p;
+
+        virtual_laws laws;
+        for (const auto& f : forces)
+        {
+            auto law = dynamic_cast<const field_force*>(f.get());
+            if (!law)
+                return nullptr;
+            laws.laws.push_back(law);
+        }
+
+        return std::make_unique<basic_field_pipeline<virtual_laws>>(std::move(laws));
+    }
+} // namespace phy::forces
@@ -1,11 +1,11 @@
+#include <cmath>
 #include <component/movement.h>
-#include <fmt/ranges.h>
-#include <logging.h>
 #include <object.h>
+#include <util/diagnostics.h>
 
 namespace phy::movement
 {
-    void default_controller::update(object& obj, float dt, const vec2d& vec)
+    void default_controller::update(object& obj, float dt, const vec2d& vec, std::size_t)
     {
         obj.set_new_acc(vec / obj.get_mass());
         obj.set_new_pos(obj.get_pos() + obj.get_vel() * dt);
@@ -13,21 +13,99 @@ namespace phy::movement
         obj.set_new_vel(obj.get_vel() + dv);
 
         if (dv.magnitude() > 750)
-        {
-            logging::logger::get_instance().nwarn("force::gravity",
-                                                  fmt::format("huge delta velocity of {}", dv.magnitude()));
-        }
+            diagnostics::count(diagnostics::HUGE_DELTA_V);
 
         if (obj.get_vel().magnitude() > 1000000)
         {
-            logging::logger::get_instance().nwarn("movement::default",
-                                                  fmt::format("velocity limit exceeded {}", obj.get_vel()));
+            diagnostics::count(diagnostics::VELOCITY_CLAMPED);
             obj.set_new_vel(obj.get_vel().normalize() * 1000000);
         }
     }
 
-    void fixed_controller::update(object& obj, float dt, const vec2d& vec)
+    void fixed_controller::update(object& obj, float dt, const vec2d&, std::size_t)
     {
         obj.set_new_pos(obj.get_pos() + obj.get_vel() * dt);
     }
+
+    // Kicks the velocity by kick * dt with the current force, then drifts the position by drift * dt with the kicked
+    // velocity.
+    //
+    // The closing kick of a leapfrog step needs the force at the positions the step ends on, which the opening kick of
+    // the next step evaluates anyway. So the closing kick by close * dt is taken with the current acceleration, and
+    // settle_kick corrects it with the force of the next step, before that step's first stage.
+    static void kick_drift(object& obj, double dt, const vec2d& vec, double kick, double drift, double close = 0)
+    {
+        vec2d acc = vec / obj.get_mass();
+        vec2d vel = obj.get_vel() + acc * (kick * dt);
+        obj.set_new_acc(acc);
+        obj.set_new_vel(vel + acc * (close * dt));
+        obj.set_new_pos(obj.get_pos() + vel * (drift * dt));
+    }
+
+    // replaces the acceleration of a closing kick by close * dt, dt being the length of the step that took it
+    static void settle_kick(object& obj, double dt, const vec2d& vec, double close)
+    {
+        vec2d acc = vec / obj.get_mass();
+        obj.set_vel(obj.get_vel() + (acc - obj.get_acc()) * (close * dt));
+        obj.set_acc(acc);
+    }
+
+    void euler_controller::update(object& obj, float dt, const vec2d& vec, std::size_t)
+    {
+        kick_drift(obj, dt, vec, 1, 1);
+    }
+
+    void verlet_controller::update(object& obj, float dt, const vec2d& vec, std::size_t)
+    {
+        kick_drift(obj, dt, vec, 0.5, 1, 0.5);
+    }
+
+    void verlet_controller::settle(object& obj, float dt, const vec2d& vec) { settle_kick(obj, dt, vec, 0.5); }
+
+    static const double W1 = 1 / (2 - std::cbrt(2.0));
+
+    void yoshida4_controller::update(object& obj, float dt, const vec2d& vec, std::size_t stage)
+    {
+        static const double W0 = -std::cbrt(2.0) * W1;
+        static const double KICK[] = {W1 / 2, (W0 + W1) / 2, (W0 + W1) / 2};
+        static const double DRIFT[] = {W1, W0, W1};
+        static const double CLOSE[] = {0, 0, W1 / 2};
+        kick_drift(obj, dt, vec, KICK[stage], DRIFT[stage], CLOSE[stage]);
+    }
+
+    void yoshida4_controller::settle(object& obj, float dt, const vec2d& vec) { settle_kick(obj, dt, vec, W1 / 2); }
+
+    void rk4_controller::update(object& obj, float dt, const vec2d& vec, std::size_t stage)
+    {
+        static constexpr double WEIGHT[] = {1, 2, 2, 1};
+        static constexpr double STEP[] = {0.5, 0.5, 1};
+
+        object_store& store = obj.get_store();
+        std::size_t i = obj.identifier();
+        vec2d acc = vec / obj.get_mass();
+        const vec2d& vel = obj.get_vel();
+
+        if (stage == 0)
+        {
+            store.base_pos[i] = obj.get_pos();
+            store.base_vel[i] = vel;
+            store.delta_pos[i] = vec2d();
+            store.delta_vel[i] = vec2d();
+        }
+
+        store.delta_pos[i] += vel * WEIGHT[stage];
+        store.delta_vel[i] += acc * WEIGHT[stage];
+        obj.set_new_acc(acc);
+
+        if (stage + 1 < stages())
+        {
+            obj.set_new_pos(store.base_pos[i] + vel * (STEP[stage] * dt));
+            obj.set_new_vel(store.base_vel[i] + acc * (STEP[stage] * dt));
+        }
+        else
+        {
+            obj.set_new_pos(store.base_pos[i] + store.delta_pos[i] * (dt / 6.0));
+            obj.set_new_vel(store.base_vel[i] + store.delta_vel[i] * (dt / 6.0));
+        }
+    }
 } // namespace phy::movement
@@ -1,31 +1,72 @@
+#include <algorithm>
+#include <cmath>
 #include <component/renderers/circle_renderer.h>
-#include <fmt/format.h>
 #include <object.h>
 
 namespace phy::render
 {
-    circle_renderer::circle_renderer(const slot_allocator& alloc) : circle(alloc_slot<sf::CircleShape>(alloc)) {}
+    static constexpr unsigned DISK_SIZE = 64;
 
-    void circle_renderer::update_phase(object& that)
+    // white disk with an antialiased edge, tinted by the vertex colors
+    static const sf::Texture& disk_texture()
     {
-        sf::CircleShape& shape = *circle.get(that.get_valuemap());
-        shape.setPosition(that.get_pos()[0] - shape.getRadius(), that.get_pos()[1] - shape.getRadius());
-    }
+        static const sf::Texture texture = [] {
+            sf::Image image;
+            image.create(DISK_SIZE, DISK_SIZE, sf::Color::Transparent);
 
-    void circle_renderer::render_phase(const object& that, sf::RenderTarget& tgt, sf::RenderStates state)
-    {
-        sf::CircleShape& shape = *circle.get(that.get_valuemap());
-        tgt.draw(shape, state);
+            double c = DISK_SIZE / 2.0;
+            for (unsigned y = 0; y < DISK_SIZE; y++)
+            {
+                for (unsigned x = 0; x < DISK_SIZE; x++)
+                {
+                    double alpha = std::clamp(c - std::hypot(x + 0.5 - c, y + 0.5 - c), 0.0, 1.0);
+                    image.setPixel(x, y, sf::Color(255, 255, 255, alpha * 255));
+                }
+            }
+
+            sf::Texture t;
+            t.loadFromImage(image);
+            t.setSmooth(true);
+            return t;
+        }();
+
+        return texture;
     }
 
+    circle_renderer::circle_renderer(const slot_allocator&) : quads(sf::Quads) {}
+
     void circle_renderer::init(object& that, const named_value_map& map)
     {
         const sf::Color& color = COLOR_KEY.at(map);
-        double radius = RADIUS_KEY.at(map);
+        ids.push_back(that.identifier());
+        radii.push_back(RADIUS_KEY.at(map));
+
+        // colors and texture coordinates never change, draw_batch only moves the corners
+        const float s = DISK_SIZE;
+        quads.append({{}, color, {0, 0}});
+        quads.append({{}, color, {s, 0}});
+        quads.append({{}, color, {s, s}});
+        quads.append({{}, color, {0, s}});
+    }
+
+    void circle_renderer::update_phase(object&) {}
+    void circle_renderer::render_phase(const object&, sf::RenderTarget&, sf::RenderStates) {}
+
+    void circle_renderer::draw_batch(const object_store& store, sf::RenderTarget& tgt, sf::RenderStates state)
+    {
+        for (std::size_t k = 0; k < ids.size(); k++)
+        {
+            float x = store.pos[ids[k]][0];
+            float y = store.pos[ids[k]][1];
+            float r = radii[k];
 
-        sf::CircleShape* shape = new sf::CircleShape(radius);
-        shape->setFillColor(color);
+            quads[4 * k].position = {x - r, y - r};
+            quads[4 * k + 1].position = {x + r, y - r};
+            quads[4 * k + 2].position = {x + r, y + r};
+            quads[4 * k + 3].position = {x - r, y + r};
+        }
 
-        circle.write(that.get_valuemap(), shape);
+        state.texture = &disk_texture();
+        tgt.draw(quads, state);
     }
 } // namespace phy::render
@@ -1,50 +1,132 @@
 #include <SFML/Graphics.hpp>
+#include <algorithm>
 #include <component/renderers/trail_renderer.h>
 #include <object.h>
+#include <vector>
 
 namespace phy::render
 {
-
-    trail_renderer::trail_renderer(const slot_allocator& alloc, double min_dist)
-        : vert(alloc_slot<sf::VertexArray>(alloc)), min_dist(min_dist), trail_color(alloc_slot<sf::Color>(alloc))
+    trail_renderer::trail_renderer(const slot_allocator& alloc, double min_dist, std::size_t max_points,
+                                   double max_age)
+        : state(alloc_slot<trail>(alloc)), min_dist(min_dist), max_points(std::max<std::size_t>(max_points, 4)),
+          max_age(max_age)
     {
     }
 
     void trail_renderer::init(object& that, const named_value_map& map)
     {
-        const sf::Color& color = COLOR_KEY.at(map);
+        state.write(that.get_valuemap(), {boost::circular_buffer<sf::Vertex>(max_points),
+                                          boost::circular_buffer<double>(max_points), COLOR_KEY.at(map)});
+    }
 
-        sf::VertexArray* varray = new sf::VertexArray(sf::PrimitiveType::LineStrip);
+    void trail_renderer::update_phase(object&)
+    {
+        // the trail only changes when sampled
+    }
 
-        vert.write(that.get_valuemap(), varray);
-        trail_color.write(that.get_valuemap(), new sf::Color(color));
+    // distance from p to the segment ab
+    static double segment_dist(const sf::Vector2f& p, const sf::Vector2f& a, const sf::Vector2f& b)
+    {
+        vec2d ab = vector_cast<double>(b - a);
+        vec2d ap = vector_cast<double>(p - a);
+        double len = ab.dot(ab);
+        double u = len > 0 ? std::clamp(ap.dot(ab) / len, 0.0, 1.0) : 0;
+        return (ap - ab * u).magnitude();
     }
 
-    void trail_renderer::update_phase(object& that)
+    void trail_renderer::compact(trail& t) const
     {
-        sf::VertexArray& vert = *this->vert.get(that.get_valuemap());
-        const sf::Color& trail_color = *this->trail_color.get(that.get_valuemap());
+        const sf::Vertex* vert = t.vert.linearize();
+        const double* time = t.time.linearize();
+        std::size_t old = t.vert.size() / 2;
 
-        sf::Vector2f vert_pos = vector_cast<float>(that.get_pos());
-        if (vert.getVertexCount() != 0)
+        // Douglas-Peucker over [0, old], iteratively so that long straight runs cannot overflow the stack
+        std::vector<bool> keep(old + 1, false);
+        keep[0] = keep[old] = true;
+        std::vector<std::pair<std::size_t, std::size_t>> stack{{0, old}};
+        while (!stack.empty())
         {
-            vec2d old1 = vector_cast<double>(vert[vert.getVertexCount() - 2].position);
-            vec2d old2 = vector_cast<double>(vert[vert.getVertexCount() - 1].position);
-            double magnitude = (old1 - old2).magnitude();
-            if (magnitude <= min_dist)
-                vert.resize(vert.getVertexCount() - 1);
-            vert.append({vert_pos, trail_color});
+            auto [a, b] = stack.back();
+            stack.pop_back();
+
+            double worst = 0;
+            std::size_t split = a;
+            for (std::size_t i = a + 1; i < b; i++)
+            {
+                double d = segment_dist(vert[i].position, vert[a].position, vert[b].position);
+                if (d > worst)
+                {
+                    worst = d;
+                    split = i;
+                }
+            }
+
+            if (worst > min_dist)
+            {
+                keep[split] = true;
+                stack.emplace_back(a, split);
+                stack.emplace_back(split, b);
+            }
         }
-        else
+
+        // if simplifying frees less than an eighth of the trail, drop the oldest vertices instead so that the next
+        // compaction is some way off
+        std::size_t kept = std::count(keep.begin(), keep.end(), true);
+        std::size_t skip = old + 1 - kept < max_points / 8 ? max_points / 8 : 0;
+
+        boost::circular_buffer<sf::Vertex> v(max_points);
+        boost::circular_buffer<double> tm(max_points);
+        for (std::size_t i = skip; i < t.vert.size(); i++)
         {
-            vert.append({vert_pos, trail_color});
-            vert.append({vert_pos, trail_color});
+            if (i > old || keep[i])
+            {
+                v.push_back(vert[i]);
+                tm.push_back(time[i]);
+            }
         }
+
+        t.vert.swap(v);
+        t.time.swap(tm);
+    }
+
+    void trail_renderer::sample_phase(const object& that, double time)
+    {
+        trail& t = *this->state.get(that.get_valuemap());
+        sf::Vertex v(vector_cast<float>(that.get_pos()), t.color);
+
+        if (max_age > 0)
+        {
+            while (!t.time.empty() && t.time.front() < time - max_age)
+            {
+                t.vert.pop_front();
+                t.time.pop_front();
+            }
+        }
+
+        // the last vertex follows the object until it is more than min_dist away from the one before
+        if (t.vert.size() >= 2)
+        {
+            vec2d old1 = vector_cast<double>(t.vert[t.vert.size() - 2].position);
+            vec2d old2 = vector_cast<double>(t.vert[t.vert.size() - 1].position);
+            if ((old1 - old2).magnitude() <= min_dist)
+            {
+                t.vert.back() = v;
+                t.time.back() = time;
+                return;
+            }
+        }
+
+        if (t.vert.full())
+            compact(t);
+
+        t.vert.push_back(v);
+        t.time.push_back(time);
     }
 
     void trail_renderer::render_phase(const object& that, sf::RenderTarget& tgt, sf::RenderStates state)
     {
-        const sf::VertexArray& vert = *this->vert.get(that.get_valuemap());
-        tgt.draw(vert, state);
+        trail& t = *this->state.get(that.get_valuemap());
+        if (t.vert.size() >= 2)
+            tgt.draw(t.vert.linearize(), t.vert.size(), sf::LineStrip, state);
     }
 } // namespace phy::render
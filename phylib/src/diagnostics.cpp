@@ -0,0 +1,97 @@
+#include <deque>
+#include <fmt/format.h>
+#include <mutex>
+#include <util/diagnostics.h>
+
+namespace phy::diagnostics
+{
+    // slots are never freed, so that counts of exited threads still add up and readers need no lock against them
+    static std::mutex registry_lock;
+    static std::deque<slots> registry;
+
+    namespace detail
+    {
+        struct release
+        {
+            slots* s = nullptr;
+            ~release()
+            {
+                if (s)
+                    s->in_use.store(false, std::memory_order_release);
+                local = nullptr;
+            }
+        };
+
+        slots* attach()
+        {
+            std::lock_guard g(registry_lock);
+
+            slots* s = nullptr;
+            for (auto& i : registry)
+            {
+                if (!i.in_use.load(std::memory_order_acquire))
+                {
+                    s = &i;
+                    s->in_use.store(true, std::memory_order_relaxed);
+                    break;
+                }
+            }
+            if (!s)
+                s = &registry.emplace_back();
+
+            thread_local release r;
+            r.s = s;
+            return local = s;
+        }
+    } // namespace detail
+
+    totals collect()
+    {
+        totals ret{};
+        std::lock_guard g(registry_lock);
+        for (const auto& i : registry)
+        {
+            for (std::size_t c = 0; c < COUNTER_COUNT; c++)
+                ret[c] += i.values[c].load(std::memory_order_relaxed);
+        }
+        return ret;
+    }
+
+    const char* name(counter c)
+    {
+        switch (c)
+        {
+        case CLOSE_ENCOUNTER:
+            return "close encounters";
+        case HUGE_DELTA_V:
+            return "huge velocity changes";
+        case VELOCITY_CLAMPED:
+            return "clamped velocities";
+        case NON_FINITE:
+            return "non-finite states";
+        default:
+            return "?";
+        }
+    }
+
+    totals reporter::poll()
+    {
+        totals now = collect();
+        totals ret;
+        for (std::size_t c = 0; c < COUNTER_COUNT; c++)
+            ret[c] = now[c] - last[c];
+        last = now;
+        return ret;
+    }
+
+    std::string reporter::describe(const totals& t)
+    {
+        std::string ret;
+        for (std::size_t c = 0; c < COUNTER_COUNT; c++)
+        {
+            if (t[c])
+                ret += fmt::format("{}{} {}", ret.empty() ? "" : ", ", t[c], name((counter)c));
+        }
+        return ret;
+    }
+} // namespace phy::diagnostics
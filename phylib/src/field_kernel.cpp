@@ -0,0 +1,301 @@
+#include <algorithm>
+#include <cmath>
+#include <util/field_kernel.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PHY_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace phy::kernel
+{
+    // targets are processed in tiles so that a tile of packed sources stays in L1 while every target of the tile
+    // streams over it
+    static constexpr std::size_t TARGET_TILE = 32;
+    static constexpr std::size_t SOURCE_TILE = 1024;
+
+    static_assert(SOURCE_TILE % SOURCE_PAD == 0);
+
+    // true if any law needs 1 / r, softened laws only need 1 / sqrt(r^2 + soft)
+    static bool any_hard(const law* laws, std::size_t nlaws)
+    {
+        for (std::size_t l = 0; l < nlaws; l++)
+        {
+            if (laws[l].soft <= 0)
+                return true;
+        }
+        return false;
+    }
+
+    static void field_sum_scalar(const law* laws, std::size_t nlaws, const double* sx, const double* sy,
+                                 const double* sm, std::size_t ns, const double* tx, const double* ty,
+                                 std::size_t begin, std::size_t end, double* ax, double* ay)
+    {
+        for (std::size_t i = begin; i < end; i++)
+        {
+            double gx = 0;
+            double gy = 0;
+            for (std::size_t j = 0; j < ns; j++)
+            {
+                double dx = tx[i] - sx[j];
+                double dy = ty[i] - sy[j];
+                double r2 = dx * dx + dy * dy;
+                if (r2 <= 0)
+                    continue;
+
+                // hard terms are magnitudes and still need dividing by r, soft terms are already divided
+                double inv = 1 / std::sqrt(r2);
+                double hard = 0;
+                double soft = 0;
+                for (std::size_t l = 0; l < nlaws; l++)
+                {
+                    double t = laws[l].constant;
+                    if (laws[l].soft > 0)
+                    {
+                        double q = 1 / std::sqrt(r2 + laws[l].soft);
+                        for (int k = 0; k <= laws[l].power; k++)
+                            t *= q;
+                        soft += t;
+                    }
+                    else
+                    {
+                        double c = std::min(inv, laws[l].cap);
+                        for (int k = 0; k < laws[l].power; k++)
+                            t *= c;
+                        hard += t;
+                    }
+                }
+
+                double s = (hard * inv + soft) * sm[j];
+                gx -= s * dx;
+                gy -= s * dy;
+            }
+
+            ax[i] += gx;
+            ay[i] += gy;
+        }
+    }
+
+#ifdef PHY_X86_KERNELS
+    __attribute__((target("avx2,fma"))) static void field_sum_avx2(const law* laws, std::size_t nlaws,
+                                                                    const double* sx, const double* sy,
+                                                                    const double* sm, std::size_t ns, const double* tx,
+                                                                    const double* ty, std::size_t begin,
+                                                                    std::size_t end, double* ax, double* ay)
+    {
+        constexpr std::size_t W = 4;
+        const __m256d zero = _mm256_setzero_pd();
+        const __m256d one = _mm256_set1_pd(1);
+        const bool hard = any_hard(laws, nlaws);
+
+        __m256d accx[TARGET_TILE];
+        __m256d accy[TARGET_TILE];
+
+        for (std::size_t tb = begin; tb < end; tb += TARGET_TILE)
+        {
+            std::size_t te = std::min(end, tb + TARGET_TILE);
+            for (std::size_t i = 0; i < TARGET_TILE; i++)
+                accx[i] = accy[i] = zero;
+
+            for (std::size_t sb = 0; sb < ns; sb += SOURCE_TILE)
+            {
+                std::size_t se = std::min(ns, sb + SOURCE_TILE);
+                for (std::size_t i = tb; i < te; i++)
+                {
+                    __m256d px = _mm256_set1_pd(tx[i]);
+                    __m256d py = _mm256_set1_pd(ty[i]);
+                    __m256d gx = accx[i - tb];
+                    __m256d gy = accy[i - tb];
+
+                    for (std::size_t j = sb; j < se; j += W)
+                    {
+                        __m256d dx = _mm256_sub_pd(px, _mm256_load_pd(sx + j));
+                        __m256d dy = _mm256_sub_pd(py, _mm256_load_pd(sy + j));
+                        __m256d r2 = _mm256_fmadd_pd(dx, dx, _mm256_mul_pd(dy, dy));
+                        __m256d mask = _mm256_cmp_pd(r2, zero, _CMP_GT_OQ);
+                        __m256d inv = hard ? _mm256_div_pd(one, _mm256_sqrt_pd(r2)) : zero;
+
+                        __m256d s = zero;
+                        __m256d soft = zero;
+                        for (std::size_t l = 0; l < nlaws; l++)
+                        {
+                            __m256d t = _mm256_set1_pd(laws[l].constant);
+                            if (laws[l].soft > 0)
+                            {
+                                __m256d q = _mm256_add_pd(r2, _mm256_set1_pd(laws[l].soft));
+                                q = _mm256_div_pd(one, _mm256_sqrt_pd(q));
+                                for (int k = 0; k <= laws[l].power; k++)
+                                    t = _mm256_mul_pd(t, q);
+                                soft = _mm256_add_pd(soft, t);
+                            }
+                            else
+                            {
+                                __m256d c = _mm256_min_pd(inv, _mm256_set1_pd(laws[l].cap));
+                                for (int k = 0; k < laws[l].power; k++)
+                                    t = _mm256_mul_pd(t, c);
+                                s = _mm256_add_pd(s, t);
+                            }
+                        }
+
+                        s = _mm256_mul_pd(_mm256_fmadd_pd(s, inv, soft), _mm256_load_pd(sm + j));
+                        s = _mm256_and_pd(s, mask);
+                        gx = _mm256_fnmadd_pd(s, dx, gx);
+                        gy = _mm256_fnmadd_pd(s, dy, gy);
+                    }
+
+                    accx[i - tb] = gx;
+                    accy[i - tb] = gy;
+                }
+            }
+
+            for (std::size_t i = tb; i < te; i++)
+            {
+                alignas(32) double lx[W];
+                alignas(32) double ly[W];
+                _mm256_store_pd(lx, accx[i - tb]);
+                _mm256_store_pd(ly, accy[i - tb]);
+                ax[i] += (lx[0] + lx[1]) + (lx[2] + lx[3]);
+                ay[i] += (ly[0] + ly[1]) + (ly[2] + ly[3]);
+            }
+        }
+    }
+
+    // The unmasked AVX-512 intrinsics of some compilers pass an uninitialized register as the source of the lanes
+    // they leave alone, which -Wmaybe-uninitialized reports, so the kernel uses their zero-masked forms with every
+    // lane selected.
+    static constexpr __mmask8 ALL = 0xff;
+
+    __attribute__((target("avx512f"))) static double reduce_add(__m512d v)
+    {
+        __m256d h = _mm256_add_pd(_mm512_maskz_extractf64x4_pd(ALL, v, 0), _mm512_maskz_extractf64x4_pd(ALL, v, 1));
+        __m128d q = _mm_add_pd(_mm256_castpd256_pd128(h), _mm256_extractf128_pd(h, 1));
+        return _mm_cvtsd_f64(_mm_add_sd(q, _mm_unpackhi_pd(q, q)));
+    }
+
+    __attribute__((target("avx512f"))) static void field_sum_avx512(const law* laws, std::size_t nlaws,
+                                                                     const double* sx, const double* sy,
+                                                                     const double* sm, std::size_t ns,
+                                                                     const double* tx, const double* ty,
+                                                                     std::size_t begin, std::size_t end, double* ax,
+                                                                     double* ay)
+    {
+        constexpr std::size_t W = 8;
+        const __m512d zero = _mm512_setzero_pd();
+        const __m512d one = _mm512_set1_pd(1);
+        const bool hard = any_hard(laws, nlaws);
+
+        __m512d accx[TARGET_TILE];
+        __m512d accy[TARGET_TILE];
+
+        for (std::size_t tb = begin; tb < end; tb += TARGET_TILE)
+        {
+            std::size_t te = std::min(end, tb + TARGET_TILE);
+            for (std::size_t i = 0; i < TARGET_TILE; i++)
+                accx[i] = accy[i] = zero;
+
+            for (std::size_t sb = 0; sb < ns; sb += SOURCE_TILE)
+            {
+                std::size_t se = std::min(ns, sb + SOURCE_TILE);
+                for (std::size_t i = tb; i < te; i++)
+                {
+                    __m512d px = _mm512_set1_pd(tx[i]);
+                    __m512d py = _mm512_set1_pd(ty[i]);
+                    __m512d gx = accx[i - tb];
+                    __m512d gy = accy[i - tb];
+
+                    for (std::size_t j = sb; j < se; j += W)
+                    {
+                        __m512d dx = _mm512_sub_pd(px, _mm512_load_pd(sx + j));
+                        __m512d dy = _mm512_sub_pd(py, _mm512_load_pd(sy + j));
+                        __m512d r2 = _mm512_fmadd_pd(dx, dx, _mm512_mul_pd(dy, dy));
+                        __mmask8 mask = _mm512_cmp_pd_mask(r2, zero, _CMP_GT_OQ);
+                        __m512d inv = hard ? _mm512_maskz_div_pd(mask, one, _mm512_maskz_sqrt_pd(mask, r2)) : zero;
+
+                        __m512d s = zero;
+                        __m512d soft = zero;
+                        for (std::size_t l = 0; l < nlaws; l++)
+                        {
+                            __m512d t = _mm512_set1_pd(laws[l].constant);
+                            if (laws[l].soft > 0)
+                            {
+                                __m512d q = _mm512_add_pd(r2, _mm512_set1_pd(laws[l].soft));
+                                q = _mm512_div_pd(one, _mm512_maskz_sqrt_pd(ALL, q));
+                                for (int k = 0; k <= laws[l].power; k++)
+                                    t = _mm512_mul_pd(t, q);
+                                soft = _mm512_add_pd(soft, t);
+                            }
+                            else
+                            {
+                                __m512d c = _mm512_maskz_min_pd(ALL, inv, _mm512_set1_pd(laws[l].cap));
+                                for (int k = 0; k < laws[l].power; k++)
+                                    t = _mm512_mul_pd(t, c);
+                                s = _mm512_add_pd(s, t);
+                            }
+                        }
+
+                        s = _mm512_maskz_mul_pd(mask, _mm512_fmadd_pd(s, inv, soft), _mm512_load_pd(sm + j));
+                        gx = _mm512_fnmadd_pd(s, dx, gx);
+                        gy = _mm512_fnmadd_pd(s, dy, gy);
+                    }
+
+                    accx[i - tb] = gx;
+                    accy[i - tb] = gy;
+                }
+            }
+
+            for (std::size_t i = tb; i < te; i++)
+            {
+                ax[i] += reduce_add(accx[i - tb]);
+                ay[i] += reduce_add(accy[i - tb]);
+            }
+        }
+    }
+#endif
+
+    isa detect()
+    {
+#ifdef PHY_X86_KERNELS
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f"))
+            return isa::AVX512;
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+            return isa::AVX2;
+#endif
+        return isa::SCALAR;
+    }
+
+    static isa current = detect();
+
+    isa active() { return current; }
+    void select(isa i) { current = std::min(i, detect()); }
+
+    const char* name(isa i)
+    {
+        switch (i)
+        {
+        case isa::AVX512:
+            return "avx512";
+        case isa::AVX2:
+            return "avx2";
+        default:
+            return "scalar";
+        }
+    }
+
+    void field_sum(const law* laws, std::size_t nlaws, const double* sx, const double* sy, const double* sm,
+                   std::size_t ns, const double* tx, const double* ty, std::size_t begin, std::size_t end, double* ax,
+                   double* ay)
+    {
+        switch (current)
+        {
+#ifdef PHY_X86_KERNELS
+        case isa::AVX512:
+            return field_sum_avx512(laws, nlaws, sx, sy, sm, ns, tx, ty, begin, end, ax, ay);
+        case isa::AVX2:
+            return field_sum_avx2(laws, nlaws, sx, sy, sm, ns, tx, ty, begin, end, ax, ay);
+#endif
+        default:
+            return field_sum_scalar(laws, nlaws, sx, sy, sm, ns, tx, ty, begin, end, ax, ay);
+        }
+    }
+} // namespace phy::kernel
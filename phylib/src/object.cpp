@@ -1,11 +1,22 @@
+#include <component/renderers/circle_renderer.h>
 #include <object.h>
 
 namespace phy
 {
-    object::object(double mass, object_class* clazz, const named_value_map& v, std::size_t id)
-        : clazz(clazz), mass(mass > 0 ? mass : 1), id(id)
+    object::object(object_store& store, double mass, object_class* clazz, const named_value_map& v)
+        : store(&store), id(store.push(mass > 0 ? mass : 1, clazz->get_id())), clazz(clazz)
     {
         clazz->init_object(*this, v);
+
+        for (const char* key : {RADIUS_KEY.name(), render::circle_renderer::RADIUS_KEY.name()})
+        {
+            auto it = v.find(key);
+            if (it != v.end())
+            {
+                set_radius(std::any_cast<double>(it->second));
+                break;
+            }
+        }
     }
 
     vec2d object::apply_force(object& obj)
@@ -16,23 +27,37 @@ namespace phy
         return v;
     }
 
-    void object::update(double dt, const vec2d& force) { this->clazz->controller->update(*this, dt, force); }
+    vec2d object::apply_body_force()
+    {
+        vec2d v;
+        for (auto& i : this->clazz->body_forces)
+            v += i->compute_force(*this);
+        return v;
+    }
 
-    void object::step_time()
+    void object::update(double dt, const vec2d& force, std::size_t stage)
     {
-        acc = new_acc;
-        vel = new_vel;
-        pos = new_pos;
+        if (stage < this->clazz->controller->stages())
+            this->clazz->controller->update(*this, dt, force, stage);
+    }
 
-        for (auto& i : this->clazz->renderers)
+    void object::settle(double dt, const vec2d& force) { this->clazz->controller->settle(*this, dt, force); }
+
+    void object::update_render()
+    {
+        for (auto i : this->clazz->object_renderers)
             i->update_phase(*this);
     }
 
+    void object::sample_history(double time) const
+    {
+        for (auto i : this->clazz->samplers)
+            i->sample_phase(*this, time);
+    }
+
     void object::draw(sf::RenderTarget& t, sf::RenderStates s) const
     {
-        for (const auto& i : this->clazz->renderers)
+        for (auto i : this->clazz->object_renderers)
             i->render_phase(*this, t, s);
     }
-
-    object::~object() { clazz->destroy_object(*this); }
 } // namespace phy
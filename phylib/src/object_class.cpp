@@ -3,16 +3,18 @@
 
 namespace phy
 {
-    void object_class::init_object(object& obj, const named_value_map& vmap) const
+    void object_class::init_object(object& obj, const named_value_map& vmap)
     {
-        obj.vmap.resize(vmap_size());
+        obj.vmap = {&slots, rows++};
+        for (auto& i : slots)
+            i->resize(rows);
         for (const auto& i : renderers)
             i->init(obj, vmap);
     }
 
-    void object_class::destroy_object(object& obj) const
+    void object_class::reserve(std::size_t n)
     {
-        for (std::size_t i = 0; i < obj.vmap.size(); i++)
-            deleters[i](obj.vmap[i]);
+        for (auto& i : slots)
+            i->reserve(rows + n);
     }
 } // namespace phy
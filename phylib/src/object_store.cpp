@@ -0,0 +1,65 @@
+#include <algorithm>
+#include <object_store.h>
+
+namespace phy
+{
+    std::size_t object_store::push(double m, std::uint32_t clazz)
+    {
+        acc.emplace_back();
+        vel.emplace_back();
+        pos.emplace_back();
+        new_acc.emplace_back();
+        new_vel.emplace_back();
+        new_pos.emplace_back();
+        mass.push_back(m);
+        radius.push_back(0);
+        class_id.push_back(clazz);
+        if (scratch)
+        {
+            base_pos.emplace_back();
+            base_vel.emplace_back();
+            delta_pos.emplace_back();
+            delta_vel.emplace_back();
+        }
+        return mass.size() - 1;
+    }
+
+    void object_store::reserve(std::size_t n)
+    {
+        acc.reserve(n);
+        vel.reserve(n);
+        pos.reserve(n);
+        new_acc.reserve(n);
+        new_vel.reserve(n);
+        new_pos.reserve(n);
+        mass.reserve(n);
+        radius.reserve(n);
+        class_id.reserve(n);
+        if (scratch)
+        {
+            base_pos.reserve(n);
+            base_vel.reserve(n);
+            delta_pos.reserve(n);
+            delta_vel.reserve(n);
+        }
+    }
+
+    void object_store::enable_scratch()
+    {
+        if (scratch)
+            return;
+
+        scratch = true;
+        base_pos.resize(size());
+        base_vel.resize(size());
+        delta_pos.resize(size());
+        delta_vel.resize(size());
+    }
+
+    void object_store::commit()
+    {
+        std::copy(new_acc.begin(), new_acc.end(), acc.begin());
+        std::copy(new_vel.begin(), new_vel.end(), vel.begin());
+        std::copy(new_pos.begin(), new_pos.end(), pos.begin());
+    }
+} // namespace phy
@@ -1,59 +1,658 @@
 #include <object.h>
 #include <SFML/Graphics.hpp>
+#include <cmath>
 #include <fmt/core.h>
 #include <iostream>
+#include <limits>
+#include <logging.h>
 #include <physics.h>
 namespace phy
 {
+    // minimum number of objects handed to a thread, below this the synchronization costs more than it saves
+    static constexpr std::size_t FORCE_GRAIN = 64;
+    static constexpr std::size_t UPDATE_GRAIN = 4096;
+
+    // side length of the tiles the pair triangle of a symmetric group is cut into
+    static constexpr std::size_t PAIR_BLOCK = 256;
+
     void physics_space::render(const std::string& msg)
     {
         counter.update();
 
-        for (std::size_t rcycle = 0; rcycle < cycles; rcycle++)
         {
-            double dt = tick.dt() * subtick_mult;
-            forces_cache.clear();
-            forces_cache.resize(objects.size());
+            auto frame = prof.time("frame");
+            advance();
+            draw(msg);
+        }
+
+        prof.end_frame();
 
-            for (std::size_t i = 0; i < objects.size(); i++)
+        if (std::chrono::steady_clock::now() - diag_time >= std::chrono::seconds(1))
+            report_diagnostics();
+    }
+
+    void physics_space::advance()
+    {
+        auto scope = prof.time("simulate");
+
+        if (groups_dirty)
+            rebuild_groups();
+
+        if (fixed_clock)
+        {
+            double dropped = fixed_clock->get_dropped();
+            std::size_t n = fixed_clock->advance(tick.dt() * subtick_mult);
+            for (std::size_t i = 0; i < n; i++)
+                step(fixed_clock->get_step());
+
+            bool now_behind = fixed_clock->get_dropped() > dropped;
+            if (now_behind && !behind)
             {
-                for (auto& j : objects)
-                    forces_cache[i] += j->apply_force(*objects[i]);
+                logging::logger::get_instance().nwarn(
+                    "phy_space", fmt::format("falling behind, dropping simulation time beyond {} steps per frame",
+                                             fixed_clock->get_max_steps()));
             }
+            behind = now_behind;
+        }
+        else
+        {
+            for (std::size_t rcycle = 0; rcycle < cycles; rcycle++)
+                step(tick.dt() * subtick_mult);
+        }
 
-            for (const auto& i : special_objects)
-                i->handle_forces(*this, forces_cache, dt);
+        if (history_interval <= 0)
+        {
+            auto scope = prof.time("history");
+            for (auto i : history_objects)
+                objects[i]->sample_history(time);
+        }
+    }
 
-            for (std::size_t i = 0; i < objects.size(); i++)
-                objects[i]->update(dt, forces_cache[i]);
-            for (const auto& i : special_objects)
-                i->handle_update(*this, dt);
-            if (t)
-                t->handle_update(*this, dt);
+    void physics_space::draw(const std::string& msg)
+    {
+        auto scope = prof.time("draw");
 
+        {
+            auto scope = prof.time("objects");
             for (const auto& i : objects)
-                i->step_time();
-            for (const auto& i : special_objects)
-                i->handle_step_time();
+                i->update_render();
+
+            // classes draw their renderers in the order they were declared, a batched one covering the whole class,
+            // so that every renderer is layered over the ones declared before it
+            for (auto c : class_table)
+            {
+                for (const auto& r : c->get_renderers())
+                {
+                    if (r->batched())
+                        r->draw_batch(*store, *rw, {});
+                    else
+                    {
+                        for (auto i : class_objects[c->get_id()])
+                            r->render_phase(*objects[i], *rw, {});
+                    }
+                }
+            }
         }
 
-        for (const auto& i : objects)
-            rw.draw(*i);
-        for (const auto& i : special_objects)
-            i->handle_render(rw);
+        {
+            auto scope = prof.time("special objects");
+            for (const auto& i : special_objects)
+                i->handle_render(*rw);
+        }
 
-        sf::Text text(fmt::format("FPS={}\n{}", counter.get(), msg), font);
+        auto overlay = prof.time("overlay");
+        std::string status = fmt::format("FPS={}", counter.get());
+        if (fixed_clock)
+            status += fmt::format(" | dropped {:.3f}s", fixed_clock->get_dropped());
+        if (prof.is_enabled())
+            status += "\n" + prof.get_summary();
+        sf::Text text(fmt::format("{}\n{}", status, msg), *font);
 
-        rw.setView(rw.getDefaultView());
+        rw->setView(rw->getDefaultView());
         if (t)
-            t->handle_render(rw);
+            t->handle_render(*rw);
         text.setPosition(0, 0);
         text.scale(0.5, 0.5);
-        rw.draw(text);
+        rw->draw(text);
+    }
+
+    void physics_space::report_diagnostics()
+    {
+        diag_time = std::chrono::steady_clock::now();
+        std::string counts = diagnostics::reporter::describe(diag.poll());
+        if (!counts.empty())
+            logging::logger::get_instance().nwarn("phy_space", counts);
+    }
+
+    void physics_space::step(double dt)
+    {
+        auto scope = prof.time("step");
+
+        if (groups_dirty)
+            rebuild_groups();
+
+        // multi-stage controllers see the state left by their previous stage, objects whose controller has fewer
+        // stages hold still after their last one
+        for (std::size_t stage = 0; stage < stages; stage++)
+        {
+            if (stage > 0)
+                store->commit();
+
+            current_stage = stage;
+            compute_forces();
+
+            {
+                auto scope = prof.time("special forces");
+                for (const auto& i : special_objects)
+                    i->handle_forces(*this, forces_cache, dt);
+            }
+
+            auto scope = prof.time("update");
+            pool->parallel_for(
+                objects.size(),
+                [&](std::size_t begin, std::size_t end) {
+                    for (std::size_t i = begin; i < end; i++)
+                    {
+                        // the closing kick of the previous step was taken with that step's length
+                        if (stage == 0 && i < stepped)
+                            objects[i]->settle(last_dt, forces_cache[i]);
+                        objects[i]->update(dt, forces_cache[i], stage);
+
+                        // a NaN or infinity anywhere makes the sum non-finite
+                        const vec2d& p = store->new_pos[i];
+                        const vec2d& v = store->new_vel[i];
+                        if (!std::isfinite(p[0] + p[1] + v[0] + v[1]))
+                            diagnostics::count(diagnostics::NON_FINITE);
+                    }
+                },
+                UPDATE_GRAIN);
+        }
+
+        current_stage = 0;
+
+        {
+            auto scope = prof.time("special update");
+            for (const auto& i : special_objects)
+                i->handle_update(*this, dt);
+        }
+
+        if (t)
+        {
+            auto scope = prof.time("tracker");
+            t->handle_update(*this, dt);
+        }
+
+        {
+            auto scope = prof.time("commit");
+            store->commit();
+        }
+
+        if (collisions.size())
+            collide();
+        time += dt;
+        last_dt = dt;
+        stepped = objects.size();
+
+        // trails and other history are only sampled when something will draw them
+        if (rw && history_interval > 0)
+        {
+            history_time += dt;
+            if (history_time >= history_interval)
+            {
+                auto scope = prof.time("history");
+                history_time = std::fmod(history_time, history_interval);
+                for (auto i : history_objects)
+                    objects[i]->sample_history(time);
+            }
+        }
+
+        for (const auto& i : special_objects)
+            i->handle_step_time();
+    }
+
+    void physics_space::synchronize()
+    {
+        if (last_dt == 0)
+            return;
+
+        auto scope = prof.time("synchronize");
+        if (groups_dirty)
+            rebuild_groups();
+
+        compute_forces();
+        for (const auto& i : special_objects)
+            i->handle_forces(*this, forces_cache, last_dt);
+
+        for (std::size_t i = 0; i < stepped; i++)
+            objects[i]->settle(last_dt, forces_cache[i]);
+    }
+
+    void physics_space::compute_forces()
+    {
+        auto scope = prof.time("forces");
+        forces_cache.clear();
+        forces_cache.resize(objects.size());
+
+        {
+            auto scope = prof.time("grid build");
+            for (auto& g : field_groups)
+            {
+                if (g.cutoff <= 0 || (neighbor_skin > 0 && !neighbors_stale(g)))
+                    continue;
+
+                g.grid.clear();
+                for (auto j : g.members)
+                    g.grid.insert(j, store->pos[j]);
+                g.grid.build(g.cutoff + neighbor_skin);
+                if (neighbor_skin > 0)
+                    build_neighbors(g);
+            }
+        }
+
+        if (opening_angle > 0)
+        {
+            auto scope = prof.time("tree build");
+            for (auto& g : field_groups)
+            {
+                if (g.cutoff > 0)
+                    continue;
+
+                g.tree.clear();
+                for (auto j : g.members)
+                    g.tree.insert(j, store->pos[j], store->mass[j]);
+                g.tree.build();
+            }
+        }
+
+        // every target is owned by exactly one thread and sums its sources in a fixed order, so the result does
+        // not depend on the number of threads
+        bool vectorized = opening_angle == 0 && any_vectorized;
+        if (opening_angle == 0)
+        {
+            if (vectorized)
+            {
+                auto scope = prof.time("pack");
+                pack_vectorized();
+            }
+
+            auto scope = prof.time("symmetric pairs");
+            for (auto& g : field_groups)
+            {
+                if (!g.vectorized && g.symmetric && g.cutoff <= 0 && current_stage < g.stages)
+                    symmetric_forces(g);
+            }
+        }
+
+        auto sum = prof.time("sum");
+        pool->parallel_for(
+            targets.size(),
+            [&](std::size_t begin, std::size_t end) {
+                // every target class only visits the source groups it feels, and only while its controller takes
+                // stages
+                for (const auto& block : target_blocks)
+                {
+                    if (block.clazz->get_controller().stages() <= current_stage)
+                        continue;
+
+                    std::size_t lo = std::max(begin, block.begin);
+                    std::size_t hi = std::min(end, block.end);
+                    if (lo < hi)
+                        sum_block(*block.clazz, lo, hi, vectorized);
+                }
+            },
+            FORCE_GRAIN);
+    }
+
+    void physics_space::sum_block(const object_class& clazz, std::size_t begin, std::size_t end, bool vectorized)
+    {
+        std::uint64_t feels = clazz.get_feel_mask();
+
+        // the packed target columns are indexed like `targets`
+        if (vectorized)
+        {
+            std::fill(field_x.begin() + begin, field_x.begin() + end, 0);
+            std::fill(field_y.begin() + begin, field_y.begin() + end, 0);
+            for (const auto& g : field_groups)
+            {
+                if (g.vectorized && (feels & g.source_group))
+                {
+                    kernel::field_sum(g.kernel_laws.data(), g.kernel_laws.size(), g.src_x.data(), g.src_y.data(),
+                                      g.src_mass.data(), g.src_mass.size(), target_x.data(), target_y.data(), begin,
+                                      end, field_x.data(), field_y.data());
+                }
+            }
+        }
+
+        if (clazz.get_body_kernel())
+            clazz.get_body_kernel()->accumulate(*store, objects.data(), targets.data() + begin, end - begin,
+                                                forces_cache.data());
+
+        for (std::size_t k = begin; k < end; k++)
+        {
+            std::size_t i = targets[k];
+            vec2d force = forces_cache[i];
+            for (auto j : direct_sources)
+            {
+                if (feels & class_table[store->class_id[j]]->get_group())
+                    force += objects[j]->apply_force(*objects[i]);
+            }
+
+            for (std::size_t g = 0; g < field_groups.size(); g++)
+            {
+                const auto& group = field_groups[g];
+                if (!(feels & group.source_group))
+                    continue;
+
+                if (group.cutoff > 0 && neighbor_skin > 0)
+                {
+                    std::size_t first = group.neighbor_start[i];
+                    force += group.pipeline->sum(*store, group.neighbors.data() + first,
+                                                 group.neighbor_start[i + 1] - first, i);
+                }
+                else if (group.cutoff > 0)
+                    group.grid.near(store->pos[i], [&](const std::size_t* ids, std::size_t n) {
+                        force += group.pipeline->sum(*store, ids, n, i);
+                    });
+                else if (opening_angle > 0)
+                    force += group.pipeline->walk(*store, group.tree, opening_angle, i);
+                else if (group.vectorized)
+                    continue;
+                else if (group.symmetric && group_of[i] == g)
+                    force += group.acc[group_slot[i]];
+                else
+                    force += group.pipeline->sum(*store, group.members.data(), group.members.size(), i);
+            }
+
+            if (vectorized)
+                force += vec2d{field_x[k], field_y[k]} * store->mass[i];
+            forces_cache[i] = force;
+        }
+    }
+
+    void physics_space::collide()
+    {
+        auto scope = prof.time("collisions");
+        {
+            auto scope = prof.time("sort");
+            collisions.sort(*store);
+            collisions.bin();
+        }
+
+        std::size_t n;
+        {
+            auto scope = prof.time("sweep");
+            n = collisions.sweep(*pool);
+        }
+
+        if (n)
+        {
+            auto scope = prof.time("response");
+            collisions.respond(*store);
+        }
+    }
+
+    bool physics_space::neighbors_stale(const field_group& group) const
+    {
+        if (group.neighbor_origin.size() != objects.size())
+            return true;
+
+        // two objects closing in on each other each cover at most half the skin before a pair that was not listed
+        // could come within the cutoff
+        double limit = neighbor_skin * neighbor_skin / 4;
+        for (std::size_t i = 0; i < objects.size(); i++)
+        {
+            vec2d d = store->pos[i] - group.neighbor_origin[i];
+            if (!(d.dot(d) <= limit))
+                return true;
+        }
+
+        return false;
+    }
+
+    void physics_space::build_neighbors(field_group& group)
+    {
+        auto scope = prof.time("neighbor lists");
+
+        double reach = group.cutoff + neighbor_skin;
+        double reach_sq = reach * reach;
+        auto visit = [&](std::size_t i, auto&& on_neighbor) {
+            const vec2d& p = store->pos[i];
+            group.grid.near(p, [&](const std::size_t* ids, std::size_t n) {
+                for (std::size_t k = 0; k < n; k++)
+                {
+                    vec2d d = store->pos[ids[k]] - p;
+                    if (ids[k] != i && d.dot(d) < reach_sq)
+                        on_neighbor(ids[k]);
+                }
+            });
+        };
+
+        auto feels = [&](std::size_t i) {
+            return (class_table[store->class_id[i]]->get_feel_mask() & group.source_group) != 0;
+        };
+
+        // counted first and filled second, so that every thread writes its own targets' slices of one flat array
+        std::size_t n = objects.size();
+        group.neighbor_start.assign(n + 1, 0);
+        pool->parallel_for(
+            targets.size(),
+            [&](std::size_t begin, std::size_t end) {
+                for (std::size_t k = begin; k < end; k++)
+                {
+                    std::size_t i = targets[k];
+                    std::size_t count = 0;
+                    if (feels(i))
+                        visit(i, [&](std::size_t) { count++; });
+                    group.neighbor_start[i + 1] = count;
+                }
+            },
+            FORCE_GRAIN);
+
+        for (std::size_t i = 0; i < n; i++)
+            group.neighbor_start[i + 1] += group.neighbor_start[i];
+
+        group.neighbors.resize(group.neighbor_start[n]);
+        pool->parallel_for(
+            targets.size(),
+            [&](std::size_t begin, std::size_t end) {
+                for (std::size_t k = begin; k < end; k++)
+                {
+                    std::size_t i = targets[k];
+                    std::size_t* out = group.neighbors.data() + group.neighbor_start[i];
+                    if (feels(i))
+                        visit(i, [&](std::size_t j) { *out++ = j; });
+                }
+            },
+            FORCE_GRAIN);
+
+        group.neighbor_origin.assign(store->pos.begin(), store->pos.begin() + n);
+    }
+
+    void physics_space::rebuild_groups()
+    {
+        constexpr std::size_t NONE = -1;
+
+        direct_sources.clear();
+        field_groups.clear();
+        any_vectorized = false;
+        group_of.assign(store->size(), NONE);
+        group_slot.assign(store->size(), 0);
+
+        targets.clear();
+        target_blocks.clear();
+        history_objects.clear();
+        collisions.clear();
+
+        stages = 1;
+        for (auto c : class_table)
+            stages = std::max(stages, c->get_controller().stages());
+
+        std::vector<std::vector<std::size_t>> class_targets(class_table.size());
+        std::vector<std::size_t> group_index(class_table.size(), NONE);
+        for (std::size_t i = 0; i < store->size(); i++)
+        {
+            std::uint32_t c = store->class_id[i];
+            bool target = class_table[c]->get_controller().consumes_forces();
+            if (target)
+                class_targets[c].push_back(i);
+            if (class_table[c]->samples_history())
+                history_objects.push_back(i);
+            if (class_table[c]->collides())
+                collisions.add(i, class_table[c]->get_restitution(), target);
+
+            const auto& forces = class_table[c]->get_forces();
+            if (forces.empty())
+                continue;
+
+            if (!class_table[c]->get_field_kernel())
+            {
+                direct_sources.push_back(i);
+                continue;
+            }
+
+            if (group_index[c] == NONE)
+            {
+                group_index[c] = field_groups.size();
+                auto& group = field_groups.emplace_back();
+                group.source_group = class_table[c]->get_group();
+                group.stages = class_table[c]->get_controller().stages();
+                group.pipeline = class_table[c]->get_field_kernel();
+                group.symmetric = class_table[c]->feels(*class_table[c]);
+                bool bounded = true;
+                for (const auto& f : forces)
+                {
+                    group.laws.push_back(static_cast<const forces::field_force*>(f.get()));
+                    bounded = bounded && group.laws.back()->cutoff() > 0;
+                    group.cutoff = std::max(group.cutoff, group.laws.back()->cutoff());
+                    group.symmetric = group.symmetric && group.laws.back()->antisymmetric();
+
+                    auto law = group.laws.back()->as_power_law();
+                    group.vectorized = group.vectorized && law && law->power >= 0 && law->power <= 16 &&
+                                       law->power == std::floor(law->power);
+                    if (group.vectorized)
+                    {
+                        double cap = law->min_dist > 0 ? 1 / law->min_dist : std::numeric_limits<double>::infinity();
+                        group.kernel_laws.push_back(
+                            {law->constant, (int)law->power, cap, law->softening * law->softening});
+                    }
+                }
+
+                if (!bounded)
+                    group.cutoff = 0;
+                any_vectorized = any_vectorized || group.vectorized;
+            }
+
+            auto& group = field_groups[group_index[c]];
+            group_of[i] = group_index[c];
+            group_slot[i] = group.members.size();
+            group.members.push_back(i);
+            group.targets += target;
+        }
+
+        // scattering every pair costs m^2 / 2 evaluations against t * m for summing onto the targets alone
+        for (auto& g : field_groups)
+            g.symmetric = g.symmetric && 2 * g.targets > g.members.size();
+
+        for (std::size_t c = 0; c < class_table.size(); c++)
+        {
+            if (class_targets[c].empty())
+                continue;
+
+            target_blocks.push_back({class_table[c], targets.size(), targets.size() + class_targets[c].size()});
+            targets.insert(targets.end(), class_targets[c].begin(), class_targets[c].end());
+        }
+
+        groups_dirty = false;
+    }
+
+    void physics_space::pack_vectorized()
+    {
+        std::size_t n = targets.size();
+        target_x.resize(n);
+        target_y.resize(n);
+        field_x.resize(n);
+        field_y.resize(n);
+        for (std::size_t k = 0; k < n; k++)
+        {
+            target_x[k] = store->pos[targets[k]][0];
+            target_y[k] = store->pos[targets[k]][1];
+        }
+
+        for (auto& g : field_groups)
+        {
+            if (!g.vectorized)
+                continue;
+
+            std::size_t m = g.members.size();
+            std::size_t padded = (m + kernel::SOURCE_PAD - 1) / kernel::SOURCE_PAD * kernel::SOURCE_PAD;
+            g.src_x.assign(padded, 0);
+            g.src_y.assign(padded, 0);
+            g.src_mass.assign(padded, 0);
+            for (std::size_t k = 0; k < m; k++)
+            {
+                std::size_t j = g.members[k];
+                g.src_x[k] = store->pos[j][0];
+                g.src_y[k] = store->pos[j][1];
+                g.src_mass[k] = store->mass[j];
+            }
+        }
+    }
+
+    void physics_space::symmetric_forces(field_group& group)
+    {
+        const std::size_t m = group.members.size();
+        const std::size_t blocks = (m + PAIR_BLOCK - 1) / PAIR_BLOCK;
+        group.acc.assign(m, vec2d());
+
+        // evaluates every pair (k, l), k < l, with k in block a and l in block b once, scattering +F/-F
+        auto tile = [&](std::size_t a, std::size_t b) {
+            group.pipeline->scatter(*store, group.members, a * PAIR_BLOCK, std::min(m, (a + 1) * PAIR_BLOCK),
+                                    b * PAIR_BLOCK, std::min(m, (b + 1) * PAIR_BLOCK), group.acc.data());
+        };
+
+        pool->parallel_for(blocks, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t a = begin; a < end; a++)
+                tile(a, a);
+        });
+
+        // Off-diagonal tiles are scheduled as a round robin tournament between blocks: no two tiles of a round share
+        // a block, so a round can be split over threads without any locking, and each block receives its
+        // contributions in an order that does not depend on the number of threads.
+        std::size_t n = blocks + (blocks & 1);
+        std::vector<std::pair<std::size_t, std::size_t>> round;
+        for (std::size_t r = 0; r + 1 < n; r++)
+        {
+            round.clear();
+            for (std::size_t k = 0; k < n / 2; k++)
+            {
+                std::size_t a = k == 0 ? n - 1 : (r + k) % (n - 1);
+                std::size_t b = (r + n - 1 - k) % (n - 1);
+                if (a < blocks && b < blocks)
+                    round.emplace_back(std::min(a, b), std::max(a, b));
+            }
+
+            pool->parallel_for(round.size(), [&](std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; i++)
+                    tile(round[i].first, round[i].second);
+            });
+        }
+    }
+
+    void physics_space::reserve(const std::string& clazz_name, std::size_t n)
+    {
+        clazz.at(clazz_name)->reserve(n);
+        store->reserve(store->size() + n);
+        objects.reserve(objects.size() + n);
     }
 
     object_builder physics_space::create_object(const std::string& clazz_name, double mass, const named_value_map& m)
     {
-        return object_builder(*objects.emplace_back(new object(mass, clazz.at(clazz_name).get(), m, objects.size())).get());
+        groups_dirty = true;
+        object_class* c = clazz.at(clazz_name).get();
+        object& obj = *objects.emplace_back(new object(*store, mass, c, m));
+        if (class_objects.size() <= c->get_id())
+            class_objects.resize(c->get_id() + 1);
+        class_objects[c->get_id()].push_back(obj.identifier());
+        return object_builder(obj);
     }
 } // namespace phy
@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <cmath>
+#include <fmt/format.h>
+#include <fstream>
+#include <util/profiler.h>
+
+namespace phy
+{
+    std::uint32_t profiler::child(std::uint32_t parent, const char* name)
+    {
+        for (std::uint32_t i = 0; i < phases.size(); i++)
+        {
+            if (phases[i].parent == parent && phases[i].name == name)
+                return i;
+        }
+
+        std::uint32_t depth = parent == NONE ? 0 : phases[parent].depth + 1;
+        phases.push_back({name, parent, depth, 0, 0, 0, {}, {}});
+        return phases.size() - 1;
+    }
+
+    void profiler::leave(clock::time_point start)
+    {
+        auto now = clock::now();
+        phase& p = phases[stack.back()];
+        p.frame_time += std::chrono::duration<double, std::milli>(now - start).count();
+        p.frame_calls++;
+
+        if (tracing && events.size() < MAX_TRACE_EVENTS)
+        {
+            using us = std::chrono::microseconds;
+            events.push_back({stack.back(), std::chrono::duration_cast<us>(start - epoch).count(),
+                              std::chrono::duration_cast<us>(now - start).count()});
+        }
+
+        stack.pop_back();
+    }
+
+    void profiler::end_frame()
+    {
+        if (!enabled)
+            return;
+
+        for (auto& p : phases)
+        {
+            p.samples.push_back(p.frame_time);
+            p.calls += p.frame_calls;
+            p.frame_time = 0;
+            p.frame_calls = 0;
+        }
+
+        frames++;
+        if (clock::now() - window_start >= std::chrono::seconds(1))
+            flush();
+    }
+
+    void profiler::flush()
+    {
+        window_start = clock::now();
+        if (frames == 0)
+            return;
+
+        for (auto& p : phases)
+        {
+            if (p.samples.empty())
+                continue;
+
+            std::sort(p.samples.begin(), p.samples.end());
+            double sum = 0;
+            for (auto i : p.samples)
+                sum += i;
+
+            std::size_t p99 = std::ceil(0.99 * p.samples.size()) - 1;
+            p.last = {p.samples.front(), sum / p.samples.size(), p.samples[p99], (double)p.calls / frames};
+            p.samples.clear();
+            p.calls = 0;
+        }
+
+        frames = 0;
+
+        // depth first, so that children follow their parent
+        summary.clear();
+        auto print = [&](auto& self, std::uint32_t parent) -> void {
+            for (std::uint32_t i = 0; i < phases.size(); i++)
+            {
+                const phase& p = phases[i];
+                if (p.parent != parent)
+                    continue;
+
+                summary += fmt::format("{:{}}{}: {:.3f}ms (min {:.3f}, p99 {:.3f}) x{:.0f}\n", "", 2 * p.depth, p.name,
+                                       p.last.mean, p.last.min, p.last.p99, p.last.calls);
+                self(self, i);
+            }
+        };
+        print(print, NONE);
+    }
+
+    bool profiler::write_trace(const std::string& file) const
+    {
+        std::ofstream os(file);
+        if (!os)
+            return false;
+
+        os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        for (std::size_t i = 0; i < events.size(); i++)
+        {
+            const event& e = events[i];
+            os << fmt::format("{}{{\"name\":\"{}\",\"ph\":\"X\",\"ts\":{},\"dur\":{},\"pid\":1,\"tid\":1}}",
+                              i ? "," : "", phases[e.phase].name, e.start, e.duration);
+        }
+        os << "]}\n";
+
+        return (bool)os;
+    }
+} // namespace phy
@@ -0,0 +1,83 @@
+#include <algorithm>
+#include <util/quadtree.h>
+
+namespace phy
+{
+    void quadtree::build()
+    {
+        nodes.clear();
+        if (bodies.empty())
+            return;
+
+        vec2d lo = bodies[0].pos;
+        vec2d hi = bodies[0].pos;
+        for (const auto& i : bodies)
+        {
+            lo[0] = std::min(lo[0], i.pos[0]);
+            lo[1] = std::min(lo[1], i.pos[1]);
+            hi[0] = std::max(hi[0], i.pos[0]);
+            hi[1] = std::max(hi[1], i.pos[1]);
+        }
+
+        vec2d extent = hi - lo;
+        double half = std::max(extent[0], extent[1]) * 0.5;
+        if (half <= 0)
+            half = 1;
+
+        nodes.reserve(bodies.size() / LEAF_SIZE * 2 + 1);
+        nodes.push_back({(lo + hi) * 0.5, half, {}, 0, 0, 0, (std::uint32_t)bodies.size()});
+        subdivide(0, 0);
+    }
+
+    void quadtree::subdivide(std::uint32_t n, std::size_t depth)
+    {
+        auto begin = bodies.begin() + nodes[n].begin;
+        auto end = bodies.begin() + nodes[n].end;
+
+        if ((std::size_t)(end - begin) <= LEAF_SIZE || depth >= MAX_DEPTH)
+        {
+            vec2d moment;
+            double mass = 0;
+            for (auto i = begin; i != end; i++)
+            {
+                moment += i->pos * i->mass;
+                mass += i->mass;
+            }
+
+            nodes[n].mass = mass;
+            nodes[n].com = mass > 0 ? moment / mass : nodes[n].center;
+            return;
+        }
+
+        vec2d center = nodes[n].center;
+        double half = nodes[n].half * 0.5;
+
+        // quadrants are laid out as (-x, -y), (+x, -y), (-x, +y), (+x, +y)
+        auto mid = std::partition(begin, end, [&](const body& b) { return b.pos[1] < center[1]; });
+        auto lower = std::partition(begin, mid, [&](const body& b) { return b.pos[0] < center[0]; });
+        auto upper = std::partition(mid, end, [&](const body& b) { return b.pos[0] < center[0]; });
+
+        auto index = [&](auto it) { return (std::uint32_t)(it - bodies.begin()); };
+        std::uint32_t bounds[5] = {index(begin), index(lower), index(mid), index(upper), index(end)};
+
+        std::uint32_t child = nodes.size();
+        nodes[n].child = child;
+        for (std::uint32_t i = 0; i < 4; i++)
+        {
+            vec2d offset{i & 1 ? half : -half, i & 2 ? half : -half};
+            nodes.push_back({center + offset, half, {}, 0, 0, bounds[i], bounds[i + 1]});
+        }
+
+        vec2d moment;
+        double mass = 0;
+        for (std::uint32_t i = 0; i < 4; i++)
+        {
+            subdivide(child + i, depth + 1);
+            moment += nodes[child + i].com * nodes[child + i].mass;
+            mass += nodes[child + i].mass;
+        }
+
+        nodes[n].mass = mass;
+        nodes[n].com = mass > 0 ? moment / mass : center;
+    }
+} // namespace phy
@@ -1,37 +1,371 @@
 #include <SFML/Graphics/PrimitiveType.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <physics.h>
 #include <special_object.h>
 
 namespace phy
 {
-    spring::spring(const object& o1, const object& o2, sf::Color color, double spring_const, double relaxed_len)
-        : o1(o1), o2(o2), color(color), spring_const(spring_const), relaxed_len(relaxed_len)
+    // springs are cheap, so the chunks are large enough to pay for handing them out
+    static constexpr std::size_t SPRING_GRAIN = 4096;
+
+    void spring_network::add(const object& o1, const object& o2, sf::Color color, double spring_const,
+                             double relaxed_len)
+    {
+        store = &o1.get_store();
+        first.push_back(o1.identifier());
+        second.push_back(o2.identifier());
+        stiffness.push_back(spring_const);
+        rest.push_back(relaxed_len);
+        lines.append({vector_cast<float>(o1.get_pos()), color});
+        lines.append({vector_cast<float>(o2.get_pos()), color});
+        index_dirty = true;
+    }
+
+    void spring_network::build_index()
+    {
+        // counting sort of both ends of every spring by object, the same as a cell_grid sorts its points
+        std::size_t max_id = 0;
+        for (std::size_t s = 0; s < first.size(); s++)
+            max_id = std::max({max_id, first[s], second[s]});
+
+        std::vector<std::size_t> count(max_id + 2, 0);
+        for (std::size_t s = 0; s < first.size(); s++)
+        {
+            count[first[s] + 1]++;
+            count[second[s] + 1]++;
+        }
+        for (std::size_t i = 0; i <= max_id; i++)
+            count[i + 1] += count[i];
+
+        incident.resize(2 * first.size());
+        std::vector<std::size_t> cursor(count.begin(), count.end() - 1);
+        for (std::size_t s = 0; s < first.size(); s++)
+        {
+            incident[cursor[first[s]]++] = 2 * s;
+            incident[cursor[second[s]]++] = 2 * s + 1;
+        }
+
+        // only objects with springs become nodes
+        nodes.clear();
+        node_start.clear();
+        for (std::size_t i = 0; i <= max_id; i++)
+        {
+            if (count[i] != count[i + 1])
+            {
+                nodes.push_back(i);
+                node_start.push_back(count[i]);
+            }
+        }
+        node_start.push_back(incident.size());
+
+        std::vector<std::size_t> node_of(max_id + 1);
+        for (std::size_t n = 0; n < nodes.size(); n++)
+            node_of[nodes[n]] = n;
+
+        other.resize(incident.size());
+        for (std::size_t k = 0; k < incident.size(); k++)
+        {
+            std::size_t s = incident[k] >> 1;
+            other[k] = node_of[incident[k] & 1 ? first[s] : second[s]];
+        }
+
+        force.resize(first.size());
+        dv.assign(nodes.size(), {});
+        index_dirty = false;
+    }
+
+    void spring_network::handle_forces(physics_space& space, std::vector<vec2d>& vec, double dt)
     {
+        if (first.empty())
+            return;
+        if (index_dirty)
+            build_index();
+
+        // later stages of a step only need forces on the objects whose controller takes them
+        bool any = false;
+        for (std::size_t n = 0; n < nodes.size() && !any; n++)
+            any = space.in_stage(nodes[n]);
+        if (!any)
+            return;
+
+        auto scope = space.get_profiler().time("springs");
+        if (implicit && dt > 0)
+            implicit_forces(space, vec, dt);
+        else
+            explicit_forces(space, vec);
     }
 
-    void spring::handle_forces(physics_space& space, std::vector<vec2d>& vec, double dt)
+    void spring_network::explicit_forces(physics_space& space, std::vector<vec2d>& vec)
     {
-        vec2d disp = o1.get_pos() - o2.get_pos();
-        double delta = disp.magnitude() - relaxed_len;
-        double force = delta * spring_const;
+        thread_pool& pool = space.get_pool();
+        const vec2d* pos = store->pos.data();
+        const std::size_t* a = first.data();
+        const std::size_t* b = second.data();
+        const double* k = stiffness.data();
+        const double* l = rest.data();
+        vec2d* f = force.data();
 
-        vec[o1.identifier()] += -disp.normalize() * force;
-        vec[o2.identifier()] += disp.normalize() * force;
+        pool.parallel_for(
+            first.size(),
+            [=](std::size_t begin, std::size_t end) {
+                for (std::size_t s = begin; s < end; s++)
+                {
+                    vec2d disp = pos[a[s]] - pos[b[s]];
+                    double len = std::sqrt(disp.dot(disp));
+                    // coincident ends pull in no direction
+                    double scale = len > 0 ? (l[s] - len) * k[s] / len : 0;
+                    f[s] = disp * scale;
+                }
+            },
+            SPRING_GRAIN);
+
+        // every node only adds to its own force, so the nodes need no synchronization
+        pool.parallel_for(
+            nodes.size(),
+            [&](std::size_t begin, std::size_t end) {
+                for (std::size_t n = begin; n < end; n++)
+                {
+                    if (!space.in_stage(nodes[n]))
+                        continue;
+
+                    vec2d sum{};
+                    for (std::size_t k = node_start[n]; k < node_start[n + 1]; k++)
+                    {
+                        std::size_t e = incident[k];
+                        sum += e & 1 ? -force[e >> 1] : force[e >> 1];
+                    }
+                    vec[nodes[n]] += sum;
+                }
+            },
+            SPRING_GRAIN);
     }
 
-    void spring::handle_update(physics_space& space, double dt)
+    // Sums what fn(begin, end, sums) adds to `sums` over [0, n). The parts only depend on the number of threads, so
+    // the result does not depend on how they are scheduled.
+    template <std::size_t N, typename F>
+    static std::array<double, N> reduce(thread_pool& pool, std::size_t n, F&& fn)
     {
-        // nop
+        std::size_t parts = pool.size();
+        std::vector<std::array<double, N>> partial(parts);
+        pool.parallel_for(parts, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t p = begin; p < end; p++)
+            {
+                partial[p] = {};
+                fn(n * p / parts, n * (p + 1) / parts, partial[p]);
+            }
+        });
+
+        std::array<double, N> ret{};
+        for (const auto& i : partial)
+        {
+            for (std::size_t k = 0; k < N; k++)
+                ret[k] += i[k];
+        }
+        return ret;
     }
 
-    void spring::handle_step_time()
+    double spring_network::apply(thread_pool& pool, double dt)
     {
-        // nop
+        // J is symmetric in the two ends of a spring, so every node sees J (x_node - x_other) whichever end it is
+        double h2 = dt * dt;
+        return reduce<1>(pool, nodes.size(), [&](std::size_t begin, std::size_t end, std::array<double, 1>& sum) {
+            for (std::size_t n = begin; n < end; n++)
+            {
+                if (node_mass[n] == 0)
+                {
+                    dir_image[n] = {};
+                    continue;
+                }
+
+                vec2d jx{};
+                for (std::size_t k = node_start[n]; k < node_start[n + 1]; k++)
+                    jx += jacobian[incident[k] >> 1] * (dir[n] - dir[other[k]]);
+                dir_image[n] = dir[n] * node_mass[n] + jx * h2;
+                sum[0] += dir[n].dot(dir_image[n]);
+            }
+        })[0];
     }
 
-    void spring::handle_render(sf::RenderTarget& target)
+    void spring_network::solve(thread_pool& pool, double dt, double rhs, double scale)
     {
-        sf::Vertex verts[]{{vector_cast<float>(o1.get_pos()), color}, {vector_cast<float>(o2.get_pos()), color}};
-        target.draw(verts, 2, sf::LineStrip);
+        iterations = 0;
+        if (!(rhs > 0))
+        {
+            std::fill(dv.begin(), dv.end(), vec2d{});
+            return;
+        }
+
+        std::size_t count = nodes.size();
+
+        // the last step's dv is the first guess
+        std::copy(dv.begin(), dv.end(), dir.begin());
+        apply(pool, dt);
+        auto start = reduce<2>(pool, count, [&](std::size_t begin, std::size_t end, std::array<double, 2>& sum) {
+            for (std::size_t n = begin; n < end; n++)
+            {
+                residual[n] -= dir_image[n];
+                precond[n] = dir[n] = inv_diag[n] * residual[n];
+                sum[0] += residual[n].dot(residual[n]);
+                sum[1] += residual[n].dot(precond[n]);
+            }
+        });
+
+        double rr = start[0];
+        double rz = start[1];
+        double stop = tolerance * tolerance * scale;
+        while (rr > stop && iterations < max_iterations)
+        {
+            double curvature = apply(pool, dt);
+            if (!(curvature > 0))
+                break;
+
+            double alpha = rz / curvature;
+            auto next = reduce<2>(pool, count, [&](std::size_t begin, std::size_t end, std::array<double, 2>& sum) {
+                for (std::size_t n = begin; n < end; n++)
+                {
+                    dv[n] += dir[n] * alpha;
+                    residual[n] -= dir_image[n] * alpha;
+                    precond[n] = inv_diag[n] * residual[n];
+                    sum[0] += residual[n].dot(residual[n]);
+                    sum[1] += residual[n].dot(precond[n]);
+                }
+            });
+
+            iterations++;
+            rr = next[0];
+            double beta = next[1] / rz;
+            rz = next[1];
+            if (rr <= stop)
+                break;
+
+            pool.parallel_for(
+                count,
+                [&](std::size_t begin, std::size_t end) {
+                    for (std::size_t n = begin; n < end; n++)
+                        dir[n] = precond[n] + dir[n] * beta;
+                },
+                SPRING_GRAIN);
+        }
+    }
+
+    void spring_network::implicit_forces(physics_space& space, std::vector<vec2d>& vec, double dt)
+    {
+        thread_pool& pool = space.get_pool();
+        std::size_t springs = first.size();
+        std::size_t count = nodes.size();
+        jacobian.resize(springs);
+        node_mass.resize(count);
+        inv_diag.resize(count);
+        residual.resize(count);
+        precond.resize(count);
+        dir.resize(count);
+        dir_image.resize(count);
+
+        {
+            const vec2d* pos = store->pos.data();
+            const std::size_t* a = first.data();
+            const std::size_t* b = second.data();
+            const double* k = stiffness.data();
+            const double* l = rest.data();
+            vec2d* f = force.data();
+            sym2* j = jacobian.data();
+
+            // the force of every spring and its derivative
+            pool.parallel_for(
+                springs,
+                [=](std::size_t begin, std::size_t end) {
+                    for (std::size_t s = begin; s < end; s++)
+                    {
+                        vec2d disp = pos[a[s]] - pos[b[s]];
+                        double len = std::sqrt(disp.dot(disp));
+                        if (len > 0)
+                        {
+                            // stiff along the spring, and across it as much as the tension pulls it back; a
+                            // compressed spring would push sideways and make the system indefinite, so it does not
+                            vec2d u = disp / len;
+                            double side = std::max(1 - l[s] / len, 0.0);
+                            f[s] = disp * ((l[s] - len) * k[s] / len);
+                            j[s] = {k[s] * (side + (1 - side) * u[0] * u[0]), k[s] * (1 - side) * u[0] * u[1],
+                                    k[s] * (side + (1 - side) * u[1] * u[1])};
+                        }
+                        else
+                        {
+                            f[s] = {};
+                            j[s] = {k[s], 0, k[s]};
+                        }
+                    }
+                },
+                SPRING_GRAIN);
+        }
+
+        // right hand side and preconditioner; objects the springs do not move are left out of the system
+        double h2 = dt * dt;
+        auto norms = reduce<2>(pool, count, [&](std::size_t begin, std::size_t end, std::array<double, 2>& sum) {
+            for (std::size_t n = begin; n < end; n++)
+            {
+                std::size_t id = nodes[n];
+                double m = store->mass[id];
+                node_mass[n] = m > 0 && space.integrates(id) ? m : 0;
+                if (node_mass[n] == 0)
+                {
+                    inv_diag[n] = {0, 0, 0};
+                    residual[n] = dv[n] = {};
+                    continue;
+                }
+
+                // the other forces on the object are part of the step too
+                vec2d f = vec[id];
+                vec2d jv{};
+                sym2 d{m, 0, m};
+                for (std::size_t k = node_start[n]; k < node_start[n + 1]; k++)
+                {
+                    std::size_t e = incident[k];
+                    std::size_t s = e >> 1;
+                    f += e & 1 ? -force[s] : force[s];
+                    jv += jacobian[s] * (store->vel[id] - store->vel[nodes[other[k]]]);
+                    d.xx += h2 * jacobian[s].xx;
+                    d.xy += h2 * jacobian[s].xy;
+                    d.yy += h2 * jacobian[s].yy;
+                }
+
+                double det = d.xx * d.yy - d.xy * d.xy;
+                inv_diag[n] = {d.yy / det, -d.xy / det, d.xx / det};
+                residual[n] = (f - jv * dt) * dt;
+                sum[0] += residual[n].dot(residual[n]);
+                sum[1] += vec[id].dot(vec[id]) * h2;
+            }
+        });
+
+        {
+            auto scope = space.get_profiler().time("solve");
+            solve(pool, dt, norms[0], std::max(norms[0], norms[1]));
+        }
+
+        // the whole force that makes a kick of the whole step change the velocity by dv
+        pool.parallel_for(
+            count,
+            [&](std::size_t begin, std::size_t end) {
+                for (std::size_t n = begin; n < end; n++)
+                {
+                    if (node_mass[n] > 0)
+                        vec[nodes[n]] = dv[n] * (node_mass[n] / dt);
+                }
+            },
+            SPRING_GRAIN);
+    }
+
+    void spring_network::handle_render(sf::RenderTarget& target)
+    {
+        if (first.empty())
+            return;
+
+        for (std::size_t s = 0; s < first.size(); s++)
+        {
+            lines[2 * s].position = vector_cast<float>(store->pos[first[s]]);
+            lines[2 * s + 1].position = vector_cast<float>(store->pos[second[s]]);
+        }
+        target.draw(lines);
     }
 } // namespace phy
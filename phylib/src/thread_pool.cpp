@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <utility>
+#include <util/thread_pool.h>
+
+namespace phy
+{
+    thread_pool::thread_pool(std::size_t n)
+    {
+        if (n == 0)
+            n = 1;
+
+        workers.reserve(n - 1);
+        for (std::size_t i = 1; i < n; i++)
+            workers.emplace_back(&thread_pool::worker, this, i);
+    }
+
+    thread_pool::~thread_pool()
+    {
+        {
+            std::lock_guard<std::mutex> g(lock);
+            stop = true;
+        }
+
+        start_cv.notify_all();
+        for (auto& i : workers)
+            i.join();
+    }
+
+    void thread_pool::worker(std::size_t index)
+    {
+        std::size_t seen = 0;
+        while (true)
+        {
+            std::unique_lock<std::mutex> l(lock);
+            start_cv.wait(l, [&]() { return stop || generation != seen; });
+            if (stop)
+                return;
+
+            seen = generation;
+            const range_fn* fn = job;
+            std::size_t n = job_size;
+            std::size_t parts = job_parts;
+            l.unlock();
+
+            if (index < parts)
+            {
+                try
+                {
+                    (*fn)(n * index / parts, n * (index + 1) / parts);
+                }
+                catch (...)
+                {
+                    l.lock();
+                    error = std::current_exception();
+                    l.unlock();
+                }
+            }
+
+            l.lock();
+            if (--pending == 0)
+                done_cv.notify_one();
+        }
+    }
+
+    void thread_pool::parallel_for(std::size_t n, const range_fn& fn, std::size_t grain)
+    {
+        std::size_t parts = std::min(size(), std::max<std::size_t>(n / std::max<std::size_t>(grain, 1), 1));
+        if (parts <= 1)
+        {
+            fn(0, n);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> g(lock);
+            job = &fn;
+            job_size = n;
+            job_parts = parts;
+            pending = workers.size();
+            generation++;
+        }
+
+        start_cv.notify_all();
+
+        std::exception_ptr local;
+        try
+        {
+            fn(0, n / parts);
+        }
+        catch (...)
+        {
+            local = std::current_exception();
+        }
+
+        std::unique_lock<std::mutex> l(lock);
+        done_cv.wait(l, [&]() { return pending == 0; });
+
+        if (!local)
+            local = std::exchange(error, nullptr);
+        error = nullptr;
+        if (local)
+            std::rethrow_exception(local);
+    }
+} // namespace phy
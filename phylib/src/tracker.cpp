@@ -1,4 +1,5 @@
 #include <fmt/ranges.h>
+#include <physics.h>
 #include <tracker.h>
 
 namespace phy
@@ -13,59 +14,64 @@ namespace phy
         ticks += dt;
         if (ticks > sample_ticks)
         {
+            const object_store& store = space.get_store();
             std::size_t index = 0;
             for (const auto& i : objects)
             {
+                const vec2d& pos = store.pos[i.id];
+                const vec2d& vel = store.vel[i.id];
+                const vec2d& acc = store.acc[i.id];
+                double mass = store.mass[i.id];
                 double value = 0;
                 switch (i.type)
                 {
                 case statspec_types::POS:
-                    value = i.obj.get_pos().magnitude();
+                    value = pos.magnitude();
                     break;
                 case statspec_types::VEL:
-                    value = i.obj.get_vel().magnitude();
+                    value = vel.magnitude();
                     break;
                 case statspec_types::MOMENTUM:
-                    value = i.obj.get_vel().magnitude() * i.obj.get_mass();
+                    value = vel.magnitude() * mass;
                     break;
                 case statspec_types::ACC:
-                    value = i.obj.get_acc().magnitude();
+                    value = acc.magnitude();
                     break;
                 case statspec_types::FORCE:
-                    value = i.obj.get_acc().magnitude() * i.obj.get_mass();
+                    value = acc.magnitude() * mass;
                     break;
                 case statspec_types::POS_X:
-                    value = i.obj.get_pos()[0];
+                    value = pos[0];
                     break;
                 case statspec_types::VEL_X:
-                    value = i.obj.get_vel()[0];
+                    value = vel[0];
                     break;
                 case statspec_types::MOMENTUM_X:
-                    value = i.obj.get_vel()[0] * i.obj.get_mass();
+                    value = vel[0] * mass;
                     break;
                 case statspec_types::ACC_X:
-                    value = i.obj.get_acc()[0];
+                    value = acc[0];
                     break;
                 case statspec_types::FORCE_X:
-                    value = i.obj.get_acc()[0] * i.obj.get_mass();
+                    value = acc[0] * mass;
                     break;
                 case statspec_types::POS_Y:
-                    value = i.obj.get_pos()[1];
+                    value = pos[1];
                     break;
                 case statspec_types::VEL_Y:
-                    value = i.obj.get_vel()[1];
+                    value = vel[1];
                     break;
                 case statspec_types::MOMENTUM_Y:
-                    value = i.obj.get_vel()[1] * i.obj.get_mass();
+                    value = vel[1] * mass;
                     break;
                 case statspec_types::ACC_Y:
-                    value = i.obj.get_acc()[1];
+                    value = acc[1];
                     break;
                 case statspec_types::FORCE_Y:
-                    value = i.obj.get_acc()[1] * i.obj.get_mass();
+                    value = acc[1] * mass;
                     break;
                 case statspec_types::KE:
-                    value = i.obj.get_vel().magnitude() * i.obj.get_vel().magnitude() * 0.5;
+                    value = vel.magnitude() * vel.magnitude() * 0.5;
                     break;
                 }
 
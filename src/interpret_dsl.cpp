@@ -662,6 +662,22 @@ static std::unordered_map<std::string, phy::statspec_types> TYPES = {
     },
 };
 
+static bool valid_group(double g)
+{
+    return g >= 0 && g < phy::object_class_builder::MAX_GROUPS && g == std::floor(g);
+}
+
+// whole numbers from 0 to `max`, which rules out NaN and infinities as well
+static bool valid_count(double n, double max)
+{
+    return n >= 0 && n <= max && n == std::floor(n);
+}
+
+// every object of a class allocates its whole trail up front
+static constexpr double MAX_TRAIL_POINTS = 1 << 20;
+// far more steps than a frame can take, the limit only keeps the count representable
+static constexpr double MAX_FRAME_STEPS = 1e9;
+
 // clang-format off
 
 // The function call registry. It currently is kind of ugly, but it should work
@@ -680,7 +696,7 @@ static call_fn FN_HANDLES[] = {
     }>("make_object"),
 
     make<void, +[](eval_context& ctx, phy::object_builder o1, phy::object_builder o2, sf::Color c, double f, double d) -> std::any {
-        ctx.space.create_special<phy::spring>(o1.get(), o2.get(), c, f, d);
+        ctx.space.springs().add(o1.get(), o2.get(), c, f, d);
         return {};
     }>("make_spring"),
 
@@ -711,6 +727,27 @@ static call_fn FN_HANDLES[] = {
         return {};
     }>("@__cons_force_gravity"),
 
+    make<void, +[](eval_context& ctx, double constant, double eps) -> std::any {
+        if (!(eps > 0))
+            ctx.errors.push_back(fmt::format("softgravity needs a positive softening length, got {}", eps));
+        else
+            ctx.builder->softgravity(constant, eps);
+        return {};
+    }>("@__cons_force_softgravity"),
+
+    make<void, +[](eval_context& ctx, double constant, double power) -> std::any {
+        ctx.builder->field(constant, power);
+        return {};
+    }>("@__cons_force_field"),
+
+    make<void, +[](eval_context& ctx, double constant, double power, double cutoff) -> std::any {
+        if (cutoff <= 0)
+            ctx.errors.push_back(fmt::format("field cutoff has to be positive, got {}", cutoff));
+        else
+            ctx.builder->field(constant, power, cutoff);
+        return {};
+    }>("@__cons_force_field"),
+
     make<void, +[](eval_context& ctx, double x, double y) -> std::any {
         ctx.builder->const_acc(x, y);
         return {};
@@ -725,6 +762,30 @@ static call_fn FN_HANDLES[] = {
         ctx.builder->force<phy::forces::force_drag>(d, (std::size_t)p);
         return {};
     }>("@__cons_force_drag"),
+
+    make<void, +[](eval_context& ctx, double restitution) -> std::any {
+        if (!(restitution >= 0 && restitution <= 1))
+            ctx.errors.push_back(fmt::format("collide restitution has to be between 0 and 1, got {}", restitution));
+        else
+            ctx.builder->collide(restitution);
+        return {};
+    }>("@__cons_property_collide"),
+
+    make<void, +[](eval_context& ctx, double group) -> std::any {
+        if (!valid_group(group))
+            ctx.errors.push_back(fmt::format("interaction groups are whole numbers from 0 to 63, got {}", group));
+        else
+            ctx.builder->group((std::size_t)group);
+        return {};
+    }>("@__cons_property_group"),
+
+    make<void, +[](eval_context& ctx, double group) -> std::any {
+        if (!valid_group(group))
+            ctx.errors.push_back(fmt::format("interaction groups are whole numbers from 0 to 63, got {}", group));
+        else
+            ctx.builder->ignores((std::size_t)group);
+        return {};
+    }>("@__cons_property_ignores"),
  
     make<void, +[](eval_context& ctx) -> std::any {
         ctx.builder->circle();
@@ -746,8 +807,11 @@ static call_fn FN_HANDLES[] = {
         return {};
     }>("@__cons_renderer_trail"),
 
-    make<void, +[](eval_context& ctx, double min_dist) -> std::any {
-        ctx.builder->trail(min_dist);
+    make<void, +[](eval_context& ctx, double min_dist, double max_points, double max_age) -> std::any {
+        if (!valid_count(max_points, MAX_TRAIL_POINTS))
+            ctx.errors.push_back(fmt::format("trail max_points is a whole number from 0 to {}, got {}", MAX_TRAIL_POINTS, max_points));
+        else
+            ctx.builder->trail(min_dist, (std::size_t) max_points, max_age);
         return {};
     }>("@__cons_renderer_trail"),
         
@@ -760,6 +824,44 @@ static call_fn FN_HANDLES[] = {
         ctx.space.set_tick_mult(ticks);
         return {};
     }>("engine_ticks_mult"),
+
+    make<void, +[](eval_context& ctx, double theta) -> std::any {
+        ctx.space.set_opening_angle(theta);
+        return {};
+    }>("engine_barnes_hut"),
+
+    make<void, +[](eval_context& ctx, double skin) -> std::any {
+        ctx.space.set_neighbor_skin(skin);
+        return {};
+    }>("engine_neighbor_skin"),
+
+    make<void, +[](eval_context& ctx, double threads) -> std::any {
+        if (!valid_count(threads, phy::physics_space::MAX_THREADS))
+            ctx.errors.push_back(fmt::format("engine_threads is a whole number from 0 to {}, got {}", phy::physics_space::MAX_THREADS, threads));
+        else
+            ctx.space.set_threads((std::size_t) threads);
+        return {};
+    }>("engine_threads"),
+
+    make<void, +[](eval_context& ctx, double step, double max_steps) -> std::any {
+        if (!(step >= 0 && std::isfinite(step)))
+            ctx.errors.push_back(fmt::format("fixed step has to be a finite number from 0, got {}", step));
+        else if (!valid_count(max_steps, MAX_FRAME_STEPS))
+            ctx.errors.push_back(fmt::format("fixed step max_steps is a whole number from 0 to {}, got {}", MAX_FRAME_STEPS, max_steps));
+        else
+            ctx.space.set_fixed_step(step, (std::size_t) max_steps);
+        return {};
+    }>("engine_fixed_step"),
+
+    make<void, +[](eval_context& ctx, double interval) -> std::any {
+        ctx.space.set_history_interval(interval);
+        return {};
+    }>("engine_history_interval"),
+
+    make<void, +[](eval_context& ctx, double on) -> std::any {
+        ctx.space.springs().set_implicit(on != 0);
+        return {};
+    }>("engine_implicit_springs"),
     
     make<phy::object_builder, +[](eval_context& ctx, double x, double y) -> std::any {
         std::any_cast<phy::object_builder>(ctx.instance.value()).pos(x, y);
@@ -906,16 +1008,32 @@ class objtype_expr_ast : public base_ast
 {
     arg_list forces;
     arg_list renderers;
+    // statements without a keyword, like collide(e), that set something about the class other than a force or renderer
+    arg_list properties;
     std::string name;
     std::string controller;
 
 public:
     virtual std::any eval(eval_context& ctx) const override
     {
+        if (ctx.space.class_exists(name))
+        {
+            ctx.errors.push_back(fmt::format("objtype {} is already defined", name));
+            return {};
+        }
+
         if (controller == "default")
             ctx.builder = &ctx.space.create_class<phy::movement::default_controller>(name);
         else if (controller == "fixed")
             ctx.builder = &ctx.space.create_class<phy::movement::fixed_controller>(name);
+        else if (controller == "euler")
+            ctx.builder = &ctx.space.create_class<phy::movement::euler_controller>(name);
+        else if (controller == "verlet")
+            ctx.builder = &ctx.space.create_class<phy::movement::verlet_controller>(name);
+        else if (controller == "yoshida4")
+            ctx.builder = &ctx.space.create_class<phy::movement::yoshida4_controller>(name);
+        else if (controller == "rk4")
+            ctx.builder = &ctx.space.create_class<phy::movement::rk4_controller>(name);
         else
         {
             ctx.errors.push_back(fmt::format("unknown movement controller {}", controller));
@@ -926,14 +1044,16 @@ public:
             safe_eval(ctx, i);
         for (const auto& i : renderers)
             safe_eval(ctx, i);
+        for (const auto& i : properties)
+            safe_eval(ctx, i);
 
         ctx.builder->build();
         return {};
     };
 
-    objtype_expr_ast(arg_list forces, arg_list renderers, std::string name, std::string controller)
-        : base_ast(value_category::RVAL), forces(std::move(forces)), renderers(std::move(renderers)), name(name),
-          controller(controller)
+    objtype_expr_ast(arg_list forces, arg_list renderers, arg_list properties, std::string name, std::string controller)
+        : base_ast(value_category::RVAL), forces(std::move(forces)), renderers(std::move(renderers)),
+          properties(std::move(properties)), name(name), controller(controller)
     {
     }
 
@@ -951,6 +1071,12 @@ public:
             os << fmt::format("renderers {}:\n", i);
             renderers[i]->dump_ast(os);
         }
+
+        for (std::size_t i = 0; i < properties.size(); i++)
+        {
+            os << fmt::format("property {}:\n", i);
+            properties[i]->dump_ast(os);
+        }
     }
 };
 
@@ -1158,6 +1284,7 @@ class parser
 
         arg_list forces;
         arg_list renderers;
+        arg_list properties;
         while (tok != '}')
         {
             if (tok.type() == token::TOK_KW_FORCE)
@@ -1190,12 +1317,26 @@ class parser
                 expect(token::TOK_SEPERATOR, "expected semicolon");
                 consume();
             }
+            else if (tok.type() == token::TOK_IDENTIFIER)
+            {
+                std::string name = tok.identifier();
+                consume();
+                auto args = parse_invoke_expr();
+                if (!args)
+                    return nullptr;
+
+                properties.push_back(std::make_unique<call_expr_ast>("@__cons_property_" + name, std::move(args.value())));
+
+                expect(token::TOK_SEPERATOR, "expected semicolon");
+                consume();
+            }
             else
-                return error("unexpected token; expected 'force' or 'renderer' keyword", tok.location());
+                return error("unexpected token; expected 'force' or 'renderer' keyword or a class property", tok.location());
         }
 
         consume();
-        return std::make_unique<objtype_expr_ast>(std::move(forces), std::move(renderers), name, control);
+        return std::make_unique<objtype_expr_ast>(std::move(forces), std::move(renderers), std::move(properties), name,
+                                                  control);
     }
 
     std::unique_ptr<base_ast> parse_paren_expr()
@@ -1371,12 +1512,9 @@ root_ast parse_file(const std::string& file)
 
 #include <ranges>
 
-phy::physics_space create_space(const std::string& file, sf::RenderWindow& rw, sf::Font& f, double subtick_mult,
-                                std::size_t cycles)
+static void populate_space(const std::string& file, phy::physics_space& space)
 {
     auto ast = parse_file(file);
-    phy::physics_space space(rw, f, subtick_mult, cycles);
-
     std::unordered_map<std::string, std::any> m;
 
     eval_context ctx{m, {}, {}, nullptr, space};
@@ -1391,6 +1529,19 @@ phy::physics_space create_space(const std::string& file, sf::RenderWindow& rw, s
 
     if (ctx.errors.size() != 0)
         exit(-1);
+}
 
+phy::physics_space create_space(const std::string& file, sf::RenderWindow& rw, sf::Font& f, double subtick_mult,
+                                std::size_t cycles)
+{
+    phy::physics_space space(rw, f, subtick_mult, cycles);
+    populate_space(file, space);
+    return space;
+}
+
+phy::physics_space create_space(const std::string& file, double subtick_mult, std::size_t cycles)
+{
+    phy::physics_space space(subtick_mult, cycles);
+    populate_space(file, space);
     return space;
 }
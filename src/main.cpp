@@ -12,16 +12,23 @@
 #include <component/renderers/arrow_renderer.h>
 #include <component/renderers/circle_renderer.h>
 #include <component/renderers/trail_renderer.h>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
 #include <exception>
 #include <filesystem>
 #include <fmt/format.h>
 #include <fmt/ranges.h>
+#include <limits>
 #include <logger_ostream.h>
 #include <logger_ref.h>
 #include <logging.h>
 #include <object.h>
 #include <physics.h>
+#include <optional>
 #include <sstream>
+#include <string_view>
 #include <util/builers.h>
 
 sf::Color rgb(uint32_t val) { return sf::Color(val << 8 | 0xff); }
@@ -68,11 +75,159 @@ bool wait_start(sf::RenderWindow& window, sf::Font& f)
 
 phy::physics_space create_space(const std::string& file, sf::RenderWindow& rw, sf::Font& f, double subtick_mult,
                                 std::size_t cycles);
+phy::physics_space create_space(const std::string& file, double subtick_mult, std::size_t cycles);
 
 extern char font_ttf[];
 extern unsigned int font_ttf_len;
 
-int start(char* file)
+struct launch_options
+{
+    const char* file = nullptr;
+    std::optional<std::size_t> threads;
+
+    bool headless = false;
+    std::size_t steps = 1000;
+    std::optional<double> dt;
+
+    bool profile = false;
+    const char* trace = nullptr;
+};
+
+// a whole number from 0 to `max` and nothing else; strtoull alone would wrap "-1" around to the largest value
+bool parse_count(const char* str, std::size_t max, std::size_t& out)
+{
+    char* end;
+    errno = 0;
+    unsigned long long n = std::strtoull(str, &end, 10);
+    if (!std::isdigit((unsigned char)*str) || *end || errno || n > max)
+        return false;
+
+    out = n;
+    return true;
+}
+
+// a finite number above 0 and nothing else
+bool parse_positive(const char* str, double& out)
+{
+    char* end;
+    errno = 0;
+    double x = std::strtod(str, &end);
+    if (end == str || *end || errno || !(x > 0 && std::isfinite(x)))
+        return false;
+
+    out = x;
+    return true;
+}
+
+bool parse_args(int argc, char** argv, launch_options& opts)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string_view arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc)
+        {
+            std::size_t n;
+            if (!parse_count(argv[++i], physics_space::MAX_THREADS, n))
+                return false;
+            opts.threads = n;
+        }
+        else if (arg == "--headless")
+            opts.headless = true;
+        else if (arg == "--steps" && i + 1 < argc)
+        {
+            if (!parse_count(argv[++i], std::numeric_limits<std::size_t>::max(), opts.steps))
+                return false;
+        }
+        else if (arg == "--dt" && i + 1 < argc)
+        {
+            double dt;
+            if (!parse_positive(argv[++i], dt))
+                return false;
+            opts.dt = dt;
+        }
+        else if (arg == "--profile")
+            opts.profile = true;
+        else if (arg == "--trace" && i + 1 < argc)
+            opts.trace = argv[++i];
+        else if (arg.starts_with("--") || opts.file)
+            return false;
+        else
+            opts.file = argv[i];
+    }
+
+    return opts.file;
+}
+
+void setup_profiler(physics_space& space, const launch_options& opts)
+{
+    space.get_profiler().set_enabled(opts.profile);
+    space.get_profiler().set_tracing(opts.trace != nullptr);
+}
+
+void write_trace(physics_space& space, const launch_options& opts, logging::logger_ref& ref)
+{
+    if (!opts.trace)
+        return;
+
+    if (space.get_profiler().write_trace(opts.trace))
+        ref.info(fmt::format("wrote trace to {}", opts.trace));
+    else
+        ref.error(fmt::format("failed to write trace to {}", opts.trace));
+}
+
+// runs the scene flat out without a window, then prints the final state of every object
+int start_headless(const launch_options& opts)
+{
+    logging::logger_ref ref("phy");
+
+    physics_space space = create_space(opts.file, 1, 1);
+    if (opts.threads)
+        space.set_threads(*opts.threads);
+    setup_profiler(space, opts);
+
+    // by default, a step is the scene's fixed step, or covers as much simulated time as one cycle of a window running
+    // at 60 FPS
+    double dt = space.get_tick_mult() / (60.0 * space.get_cycles());
+    if (opts.dt)
+        dt = *opts.dt;
+    else if (space.get_fixed_step() > 0)
+        dt = space.get_fixed_step();
+    ref.info(fmt::format("running {} steps of dt={} on {} thread(s)", opts.steps, dt, space.get_threads()));
+
+    auto begin = std::chrono::steady_clock::now();
+    profiler& prof = space.get_profiler();
+    for (std::size_t i = 0; i < opts.steps; i++)
+    {
+        space.step(dt);
+        // a profiler frame spans as many steps as a window frame would
+        if ((i + 1) % space.get_cycles() == 0)
+            prof.end_frame();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    ref.info(fmt::format("{} steps in {:.3f}s, {:.1f} steps/s", opts.steps, elapsed, opts.steps / elapsed));
+    space.report_diagnostics();
+    if (prof.is_enabled())
+    {
+        if (opts.steps % space.get_cycles())
+            prof.end_frame();
+        prof.flush();
+        ref.info(fmt::format("per frame of {} steps:\n{}", space.get_cycles(), prof.get_summary()));
+    }
+    write_trace(space, opts, ref);
+
+    const object_store& store = space.get_store();
+    fmt::print("id mass pos_x pos_y vel_x vel_y\n");
+    for (std::size_t i = 0; i < store.size(); i++)
+    {
+        fmt::print("{} {} {} {} {} {}\n", i, store.mass[i], store.pos[i][0], store.pos[i][1], store.vel[i][0],
+                   store.vel[i][1]);
+    }
+
+    return 0;
+}
+
+int start(const launch_options& opts)
 {
     sf::RenderWindow window(sf::VideoMode(1440, 1080), "Physics Sim");
     sf::Font font;
@@ -85,7 +240,11 @@ int start(char* file)
         return 0;
 
     ref.info("starting window");
-    physics_space space = create_space(file, window, font, 1, 1);
+    physics_space space = create_space(opts.file, window, font, 1, 1);
+    if (opts.threads)
+        space.set_threads(*opts.threads);
+    setup_profiler(space, opts);
+    ref.info(fmt::format("using {} thread(s)", space.get_threads()));
 
     sf::Vector2i mouse_pos = sf::Mouse::getPosition();
     sf::View v = window.getDefaultView();
@@ -155,6 +314,7 @@ int start(char* file)
         window.display();
     }
 
+    write_trace(space, opts, ref);
     ref.info("closing...");
 
     return 0;
@@ -162,9 +322,12 @@ int start(char* file)
 
 int main(int argc, char** argv)
 {
-    if (argc != 2)
+    launch_options opts;
+    if (!parse_args(argc, argv, opts))
     {
-        std::cerr << fmt::format("usage: {} [config_filename]", argv[0]);
+        std::cerr << fmt::format("usage: {} [--threads n] [--profile] [--trace file] [--headless [--steps n] [--dt x]] "
+                                 "[config_filename]",
+                                 argv[0]);
         exit(-1);
     }
 
@@ -172,7 +335,7 @@ int main(int argc, char** argv)
 
     try
     {
-        return start(argv[1]);
+        return opts.headless ? start_headless(opts) : start(opts);
     }
     catch (std::exception& e)
     {